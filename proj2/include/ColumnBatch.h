@@ -0,0 +1,38 @@
+#ifndef COLUMNBATCH_H
+#define COLUMNBATCH_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Column oriented storage for a batch of DSV rows. Each column keeps all of
+// its values back to back in one character array, value i of the column is
+// DData[DOffsets[i], DOffsets[i + 1]). Clearing a batch keeps the capacity so
+// a batch can be reused without allocating.
+class CColumnBatch{
+    public:
+        struct SColumn{
+            std::vector< char > DData;
+            std::vector< std::size_t > DOffsets = {0};
+
+            std::string_view Value(std::size_t row) const;
+        };
+
+    private:
+        std::vector< SColumn > DColumns;
+        std::size_t DColumnCount = 0;
+        std::size_t DRowCount = 0;
+
+    public:
+        std::size_t RowCount() const;
+        std::size_t ColumnCount() const;
+        const SColumn &Column(std::size_t column) const;
+        std::string_view Value(std::size_t column, std::size_t row) const;
+
+        void Clear();
+        // Rows shorter than the batch are padded with empty values, a longer
+        // row adds columns that are empty for the earlier rows
+        void AppendRow(const std::vector< std::string_view > &row);
+};
+
+#endif
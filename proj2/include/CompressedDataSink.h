@@ -0,0 +1,38 @@
+#ifndef COMPRESSEDDATASINK_H
+#define COMPRESSEDDATASINK_H
+
+#include "Compression.h"
+#include "DataSink.h"
+#include <memory>
+
+// Compresses everything written to it into another sink. Input is collected
+// into blocks of blocksize bytes before it is compressed, blocks at least
+// that large are compressed straight from the caller's memory.
+class CCompressedDataSink : public CDataSink{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+    public:
+        // CompressionDefaultLevel selects the format's default level. windowbits
+        // is the base two logarithm of the window size, zero selects the
+        // default. Zstd windows are capped at CompressionZstdMaxWindowLog so
+        // CCompressedDataSource can read the output.
+        CCompressedDataSink(std::shared_ptr< CDataSink > sink, ECompressionFormat format = ECompressionFormat::Gzip, int level = CompressionDefaultLevel, int windowbits = 0, std::size_t blocksize = 1024 * 1024);
+        // Finishes the stream
+        ~CCompressedDataSink();
+
+        // Returns false if the format is not supported
+        bool IsOpen() const noexcept;
+        // Compresses the pending input and ends the compressed stream,
+        // nothing can be written afterwards
+        bool Finish() noexcept;
+
+        bool Put(const char &ch) noexcept override;
+        bool Write(const std::vector<char> &buf) noexcept override;
+        bool WriteBlock(const char *buf, std::size_t count) noexcept override;
+        // Compresses the pending input so everything written so far can be
+        // decompressed from the output, then flushes the underlying sink
+        bool Flush() noexcept override;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef COMPRESSEDDATASOURCE_H
+#define COMPRESSEDDATASOURCE_H
+
+#include "Compression.h"
+#include "DataSource.h"
+#include <memory>
+
+// Decompresses another source as it is read. With background the input is
+// decompressed blocksize bytes at a time on a separate thread, up to a few
+// blocks ahead of the reader, so decompression overlaps with parsing.
+class CCompressedDataSource : public CDataSource{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+    public:
+        CCompressedDataSource(std::shared_ptr< CDataSource > src, ECompressionFormat format = ECompressionFormat::Auto, bool background = true, std::size_t blocksize = 1024 * 1024);
+        ~CCompressedDataSource();
+
+        // The format being read, Auto is resolved from the first bytes
+        ECompressionFormat Format() const noexcept;
+        // Returns true if the input is corrupt, truncated or in an
+        // unsupported format, the source then ends early
+        bool Error() const noexcept;
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        std::size_t ReadBlock(char *buf, std::size_t count) noexcept override;
+};
+
+#endif
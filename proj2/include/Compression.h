@@ -0,0 +1,33 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <climits>
+
+#if __has_include(<zstd.h>)
+#define COMPRESSION_ZSTD
+#endif
+
+// Formats of CCompressedDataSource and CCompressedDataSink. Auto is only
+// valid for reading, it detects gzip and zstd from the first bytes and reads
+// anything else as uncompressed.
+enum class ECompressionFormat{Auto, None, Gzip, Zlib, Zstd};
+
+// Selects the format's own default level. Zstd also has negative levels, so
+// no ordinary level can stand for the default.
+constexpr int CompressionDefaultLevel = INT_MIN;
+
+// Largest zstd window, as a base two logarithm, that is written or accepted
+// when reading. Frames that need a larger window are an error instead of an
+// allocation of that size.
+constexpr int CompressionZstdMaxWindowLog = 27;
+
+// Zstd support depends on the zstd headers being present at build time
+inline bool CompressionFormatSupported(ECompressionFormat format){
+#ifdef COMPRESSION_ZSTD
+    return true;
+#else
+    return format != ECompressionFormat::Zstd;
+#endif
+}
+
+#endif
@@ -1,9 +1,13 @@
 #ifndef DSVREADER_H
 #define DSVREADER_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "DataSource.h"
+#include "ColumnBatch.h"
 
 class CDSVReader{
     private:
@@ -11,11 +15,40 @@ class CDSVReader{
         std::unique_ptr<SImplementation> DImplementation;
 
     public:
-        CDSVReader(std::shared_ptr< CDataSource > src, char delimiter);
+        enum class EColumnType{Int64, Double, Bool, String, Skip};
+        struct STypedField{
+            EColumnType DType;
+            // False if the column is missing from the row or does not parse
+            bool DValid;
+            int64_t DInt64;
+            double DDouble;
+            bool DBool;
+            std::string_view DString;
+        };
+
+        // Once a row is longer than maxrowsize bytes a newline ends it even
+        // inside a quoted field, so a quote that is never closed cannot pull
+        // the rest of the input into memory. There is no limit by default,
+        // since a limit splits valid quoted fields that are longer.
+        CDSVReader(std::shared_ptr< CDataSource > src, char delimiter, std::size_t maxrowsize = SIZE_MAX);
         ~CDSVReader();
 
         bool End() const;
         bool ReadRow(std::vector<std::string> &row);
+        // Same as ReadRow, but the fields point into the reader's buffer and
+        // are only valid until the next call to End, ReadRow or ReadRowView
+        bool ReadRowView(std::vector<std::string_view> &row);
+        // Clears batch and fills it with up to maxrows rows, skipping empty
+        // lines. Returns false if no rows were read.
+        bool ReadBatch(std::size_t maxrows, CColumnBatch &batch);
+        // Declares the type of each column for ReadTypedRow, columns past the
+        // end of the schema are skipped
+        void SetSchema(const std::vector<EColumnType> &schema);
+        // Reads a row and parses each column of the schema directly from the
+        // input, one field per column that is not skipped. Skipped columns are
+        // never unquoted or copied, and string fields are only valid until
+        // the next read like ReadRowView.
+        bool ReadTypedRow(std::vector<STypedField> &row);
 };
 
 #endif
@@ -0,0 +1,62 @@
+#ifndef DSVSCANNER_H
+#define DSVSCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Vectorized structural character scanner used by CDSVReader. Input is
+// classified 64 bytes at a time into bitmasks, the widest instruction set the
+// CPU supports is picked at startup.
+namespace DSVScanner{
+
+constexpr std::size_t BlockSize = 64;
+
+enum class EImplementation{Scalar, SSE2, AVX2};
+
+// Bit i of each mask is set when byte i of the block is that character
+struct SBlockMasks{
+    uint64_t DQuote;
+    uint64_t DDelimiter;
+    uint64_t DNewline;
+};
+
+// Classifies the first length bytes (at most BlockSize) of data
+SBlockMasks Classify(const char *data, std::size_t length, char delimiter) noexcept;
+
+// Quoting state of a row scan, kept between calls so a scan can resume once
+// more input is available
+struct SScanState{
+    bool DInQuotes = false;
+    // The last character scanned was a quote inside a quoted field, the
+    // next one decides whether it is escaped or closes the field
+    bool DQuotePending = false;
+    // Offsets where the current field and row begin
+    std::size_t DFieldStart = 0;
+    std::size_t DRowStart = 0;
+    // Once a row is longer than this a newline ends it even inside a quoted
+    // field, so a quote that is never closed cannot swallow all the input
+    std::size_t DMaxRowSize = SIZE_MAX;
+};
+
+// Finds the end of a row, the offset of the first newline outside of quotes or
+// length if there is none. Scanning begins at start with the state left by
+// the previous call, a new state when data is the start of a row. The offsets
+// of all unquoted delimiters before the row end are appended to delimiters.
+// The state can be kept to scan the following rows.
+// A quote only opens a quoted field as the first character of the field,
+// inside one "" is an escaped quote and any other quote closes it.
+std::size_t FindRowEnd(const char *data, std::size_t start, std::size_t length, char delimiter, SScanState &state, std::vector< std::size_t > &delimiters) noexcept;
+
+// Same as FindRowEnd without collecting delimiters, but rows that end before
+// minimum are passed over. Scanning to minimum == length leaves the start of
+// the last incomplete row in state.DRowStart.
+std::size_t FindRowEndAfter(const char *data, std::size_t start, std::size_t minimum, std::size_t length, char delimiter, SScanState &state) noexcept;
+
+EImplementation ActiveImplementation() noexcept;
+// Returns false if the CPU does not support the implementation
+bool SelectImplementation(EImplementation implementation) noexcept;
+
+}
+
+#endif
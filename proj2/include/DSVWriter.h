@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include "DataSink.h"
 
 class CDSVWriter{
@@ -11,10 +12,13 @@ class CDSVWriter{
         std::unique_ptr<SImplementation> DImplementation;
 
     public:
-        CDSVWriter(std::shared_ptr< CDataSink > sink, char delimiter, bool quoteall = false);
+        // Rows are buffered until at least flushthreshold bytes are pending,
+        // the default of zero writes every row to the sink immediately
+        CDSVWriter(std::shared_ptr< CDataSink > sink, char delimiter, bool quoteall = false, std::size_t flushthreshold = 0);
         ~CDSVWriter();
 
         bool WriteRow(const std::vector<std::string> &row);
+        bool Flush();
 };
 
 #endif
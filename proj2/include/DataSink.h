@@ -2,12 +2,27 @@
 #define DATASINK_H
 
 #include <vector>
+#include <cstddef>
 
 class CDataSink{
     public:
         virtual ~CDataSink(){};
         virtual bool Put(const char &ch) noexcept = 0;
         virtual bool Write(const std::vector<char> &buf) noexcept = 0;
+        // Writes count bytes from buf, sinks that can append a whole block at
+        // once should override this instead of relying on Put per byte.
+        virtual bool WriteBlock(const char *buf, std::size_t count) noexcept{
+            for(std::size_t Index = 0; Index < count; Index++){
+                if(!Put(buf[Index])){
+                    return false;
+                }
+            }
+            return true;
+        };
+        // Hands any data the sink buffers itself on to its destination
+        virtual bool Flush() noexcept{
+            return true;
+        };
 };
 
 #endif
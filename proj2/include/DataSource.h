@@ -2,6 +2,7 @@
 #define DATASOURCE_H
 
 #include <vector>
+#include <cstddef>
 
 class CDataSource{
     public:
@@ -10,6 +11,16 @@ class CDataSource{
         virtual bool Get(char &ch) noexcept = 0;
         virtual bool Peek(char &ch) noexcept = 0;
         virtual bool Read(std::vector<char> &buf, std::size_t count) noexcept = 0;
+        // Copies up to count bytes into buf and returns the number copied, a
+        // return of zero means the source is exhausted. Sources that hold
+        // their data contiguously should override this with a bulk copy.
+        virtual std::size_t ReadBlock(char *buf, std::size_t count) noexcept{
+            std::size_t Index = 0;
+            while((Index < count) && Get(buf[Index])){
+                Index++;
+            }
+            return Index;
+        };
 };
 
 #endif
@@ -0,0 +1,41 @@
+#ifndef FILEDATASINK_H
+#define FILEDATASINK_H
+
+#include "DataSink.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Writes to a file through one large page aligned buffer. Small writes are
+// coalesced in the buffer, blocks at least as large as the buffer are
+// written together with it in a single writev() without being copied.
+class CFileDataSink : public CDataSink{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+    public:
+        // When the data is forced to the device with fdatasync()
+        enum class ESyncPolicy{None, OnFlush, OnClose};
+
+        // Creates or truncates filename. With directio the file is opened
+        // with O_DIRECT if the file system supports it, the last partial
+        // block is written without it.
+        CFileDataSink(const std::string &filename, bool directio = false, ESyncPolicy sync = ESyncPolicy::None, std::size_t buffersize = 1024 * 1024);
+        // Does not take ownership of fd
+        CFileDataSink(int fd, ESyncPolicy sync = ESyncPolicy::None, std::size_t buffersize = 1024 * 1024);
+        // Flushes the buffer
+        ~CFileDataSink();
+
+        bool IsOpen() const noexcept;
+        // Returns true while writes bypass the page cache with O_DIRECT
+        bool IsDirect() const noexcept;
+        // Number of bytes written to the file so far, not counting the buffer
+        uint64_t BytesWritten() const noexcept;
+
+        bool Put(const char &ch) noexcept override;
+        bool Write(const std::vector<char> &buf) noexcept override;
+        bool WriteBlock(const char *buf, std::size_t count) noexcept override;
+        bool Flush() noexcept override;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef FILEDATASOURCE_H
+#define FILEDATASOURCE_H
+
+#include "DataSource.h"
+#include <memory>
+#include <string>
+
+// Reads directly from a file. Regular files are memory mapped so no copy of
+// the input is made up front, pipes and other streams fall back to read().
+class CFileDataSource : public CDataSource{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+    public:
+        CFileDataSource(const std::string &filename);
+        // Does not take ownership of fd
+        CFileDataSource(int fd);
+        ~CFileDataSource();
+
+        bool IsOpen() const noexcept;
+        bool IsMapped() const noexcept;
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        std::size_t ReadBlock(char *buf, std::size_t count) noexcept override;
+};
+
+#endif
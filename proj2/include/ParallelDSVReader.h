@@ -0,0 +1,38 @@
+#ifndef PARALLELDSVREADER_H
+#define PARALLELDSVREADER_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "DataSource.h"
+
+// Reads DSV input in large blocks that are split into chunks at row
+// boundaries and parsed on separate threads with the same rules as
+// CDSVReader::ReadRow. Like CDSVReader, ReadRow returns false with an empty
+// row for an empty line, and the chunks hold empty lines as empty rows.
+class CParallelDSVReader{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        using TChunkCallback = std::function< void(std::size_t chunkindex, std::vector< std::vector< std::string > > &rows) >;
+
+        // A thread count of zero uses one thread per hardware core. The buffer
+        // grows up to threads * chunksize bytes as the input requires,
+        // maxrowsize is passed on to CDSVReader.
+        CParallelDSVReader(std::shared_ptr< CDataSource > src, char delimiter, std::size_t threads = 0, std::size_t chunksize = 16 * 1024 * 1024, std::size_t maxrowsize = SIZE_MAX);
+        ~CParallelDSVReader();
+
+        bool End() const;
+        // Returns the rows in input order
+        bool ReadRow(std::vector<std::string> &row);
+        // Parses all remaining input, calling callback on the worker threads
+        // with the rows of each chunk. Chunks are numbered in input order but
+        // the callbacks may run concurrently and out of order.
+        bool ReadChunks(const TChunkCallback &callback);
+};
+
+#endif
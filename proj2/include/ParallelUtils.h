@@ -0,0 +1,24 @@
+#ifndef PARALLELUTILS_H
+#define PARALLELUTILS_H
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ParallelUtils{
+
+// Runs function(0) ... function(count - 1) each on its own thread
+template <typename TFunction> void RunParallel(std::size_t count, TFunction function){
+    std::vector< std::thread > Threads;
+    Threads.reserve(count);
+    for(std::size_t Index = 0; Index < count; Index++){
+        Threads.emplace_back(function, Index);
+    }
+    for(auto &Thread : Threads){
+        Thread.join();
+    }
+}
+
+}
+
+#endif
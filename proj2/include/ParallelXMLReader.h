@@ -0,0 +1,38 @@
+#ifndef PARALLELXMLREADER_H
+#define PARALLELXMLREADER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "DataSource.h"
+#include "XMLEntity.h"
+
+// Reads documents made of one root element holding many independent sibling
+// records, such as <rows><row>...</row>...</rows>. The input is read in
+// large blocks that are split between the records and parsed on separate
+// threads, each with its own CXMLReader. Every chunk is parsed wrapped in
+// the document's prolog and root start tag, so namespace declarations and
+// internal DTD entities still apply.
+class CParallelXMLReader{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        // Records are the children of the root named recordname, or all of its
+        // children if recordname is empty. A thread count of zero uses one
+        // thread per hardware core.
+        CParallelXMLReader(std::shared_ptr< CDataSource > src, const std::string &recordname, std::size_t threads = 0, std::size_t chunksize = 16 * 1024 * 1024);
+        ~CParallelXMLReader();
+
+        bool End() const;
+        // Returns the entities of the next record in input order, from its
+        // start element to its end element. Returns false at the end of the
+        // document or after a parse error.
+        bool ReadRecord(std::vector< SXMLEntity > &record);
+        // Returns true if the document failed to parse, including when it is
+        // truncated. The records before the error are still returned.
+        bool Error() const;
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef PREFETCHDATASOURCE_H
+#define PREFETCHDATASOURCE_H
+
+#include "DataSource.h"
+#include <memory>
+
+// Reads another source ahead on a background thread. The thread fills a ring
+// of blockcount buffers of blocksize bytes while the reader consumes earlier
+// ones, so at most blocksize * blockcount bytes are ever held.
+class CPrefetchDataSource : public CDataSource{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+    public:
+        CPrefetchDataSource(std::shared_ptr< CDataSource > src, std::size_t blocksize = 1024 * 1024, std::size_t blockcount = 4);
+        // Stops the background thread once its current read returns
+        ~CPrefetchDataSource();
+
+        // Number of times the reader had to wait for the source
+        std::size_t Stalls() const noexcept;
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        std::size_t ReadBlock(char *buf, std::size_t count) noexcept override;
+};
+
+#endif
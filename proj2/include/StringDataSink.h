@@ -3,15 +3,40 @@
 
 #include "DataSink.h"
 #include <string>
+#include <sys/uio.h>
 
+// Collects the output in memory as a list of chunks. A chunk is never
+// reallocated once created, so appending never copies earlier output, and
+// each new chunk is about as large as everything before it. String()
+// combines the chunks into one with spare room, later writes append to it
+// until it is full. The sink is not thread safe, String() changes the
+// chunks and must not run at the same time as a write or another call.
 class CStringDataSink : public CDataSink{
     private:
-        std::string DString;
+        mutable std::vector< std::string > DChunks;
+        std::size_t DSize = 0;
+
+        void AddChunk(std::size_t capacity);
+        // Replaces the chunks with a single one holding all of the output
+        void Combine() const;
     public:
+        // Combines the chunks, the output itself is left unchanged. The
+        // reference is invalidated by the next write, since that may start a
+        // new chunk, so copy the string to keep it across writes.
         const std::string &String() const;
+        std::size_t Size() const;
+        // Makes room for a total of size bytes, so the output up to that size
+        // ends up in a single chunk
+        void Reserve(std::size_t size);
+        // Moves the output out of the sink, leaving it empty
+        std::string Take();
+        std::vector< std::string > TakeChunks();
+        // Views of the chunks for writev(), valid until the next write
+        std::vector< struct iovec > IOVectors() const;
 
         bool Put(const char &ch) noexcept override;
         bool Write(const std::vector<char> &buf) noexcept override;
+        bool WriteBlock(const char *buf, std::size_t count) noexcept override;
 };
 
 #endif
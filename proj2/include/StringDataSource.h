@@ -1,20 +1,21 @@
 #ifndef STRINGDATASOURCE_H
 #define STRINGDATASOURCE_H
 
-#include "DataSource.h"
+#include "StringViewDataSource.h"
 #include <string>
 
-class CStringDataSource : public CDataSource{
+// Reads from its own copy of the string, the reading itself is done by the
+// view over that copy
+class CStringDataSource : public CStringViewDataSource{
     private:
         std::string DString;
-        size_t DIndex;
     public:
         CStringDataSource(const std::string &str);
-
-        bool End() const noexcept override;
-        bool Get(char &ch) noexcept override;
-        bool Peek(char &ch) noexcept override;
-        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        // Takes over the string instead of copying it
+        CStringDataSource(std::string &&str);
+        // Copies read from their own string at the position of the original
+        CStringDataSource(const CStringDataSource &source);
+        CStringDataSource &operator=(const CStringDataSource &source);
 };
 
 #endif
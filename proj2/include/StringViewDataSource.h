@@ -0,0 +1,27 @@
+#ifndef STRINGVIEWDATASOURCE_H
+#define STRINGVIEWDATASOURCE_H
+
+#include "DataSource.h"
+#include <string_view>
+
+// Reads from memory owned by the caller without copying it, the memory must
+// stay valid and unchanged for the lifetime of the source
+class CStringViewDataSource : public CDataSource{
+    private:
+        std::string_view DString;
+        std::size_t DIndex;
+    protected:
+        // Points the source at str, keeping the read position
+        void Rebind(std::string_view str) noexcept;
+    public:
+        CStringViewDataSource(std::string_view str);
+        CStringViewDataSource(const char *data, std::size_t length);
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        std::size_t ReadBlock(char *buf, std::size_t count) noexcept override;
+};
+
+#endif
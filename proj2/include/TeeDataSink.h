@@ -0,0 +1,36 @@
+#ifndef TEEDATASINK_H
+#define TEEDATASINK_H
+
+#include "DataSink.h"
+#include <memory>
+
+// Writes everything written to it to each of several child sinks. Each block
+// is passed to every child as is, without a copy per child. In threaded mode
+// every child is written by its own thread from its own queue of blocks;
+// input is gathered into shared blocks of blocksize bytes and a child may
+// fall at most queuedepth blocks behind before writes wait for it.
+// A child that fails is skipped from then on while the others carry on.
+class CTeeDataSink : public CDataSink{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+    public:
+        CTeeDataSink(std::vector< std::shared_ptr< CDataSink > > sinks, bool threaded = false, std::size_t blocksize = 64 * 1024, std::size_t queuedepth = 16);
+        // Flushes and, in threaded mode, waits for every child to finish
+        ~CTeeDataSink();
+
+        std::size_t ChildCount() const noexcept;
+        // Returns true if writing or flushing the child at index has failed.
+        // In threaded mode failures surface once the child reaches the data,
+        // Flush waits for that.
+        bool ChildFailed(std::size_t index) const noexcept;
+
+        // Return false once any child has failed
+        bool Put(const char &ch) noexcept override;
+        bool Write(const std::vector<char> &buf) noexcept override;
+        bool WriteBlock(const char *buf, std::size_t count) noexcept override;
+        // Hands buffered data to the children and flushes each of them
+        bool Flush() noexcept override;
+};
+
+#endif
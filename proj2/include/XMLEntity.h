@@ -1,48 +1,249 @@
 #ifndef XMLENTITY_H
 #define XMLENTITY_H
 
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
 #include <utility>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// Attributes of an element in insertion order. Small lists are searched
+// linearly, once a list grows past IndexThreshold an open addressing hash
+// index of the names is kept alongside so lookups stay constant time.
+// Removed attributes are kept as spare storage so clearing and refilling a
+// list reuses the strings it already allocated.
+class CXMLAttributeList{
+    public:
+        using TAttribute = std::pair< std::string, std::string >;
+        using value_type = TAttribute;
+        using size_type = std::vector< TAttribute >::size_type;
+        using const_iterator = std::vector< TAttribute >::const_iterator;
+        // Names are indexed, so attributes are only changed through Set
+        using iterator = const_iterator;
+        static constexpr size_type IndexThreshold = 8;
+
+    private:
+        // Only the first DCount attributes are in the list
+        std::vector< TAttribute > DAttributes;
+        size_type DCount = 0;
+        // Slot values are attribute index + 1, zero marks an empty slot
+        std::vector< uint32_t > DIndex;
+
+        static std::size_t Hash(std::string_view name){
+            return std::hash< std::string_view >()(name);
+        };
+
+        void IndexAttribute(size_type index){
+            std::size_t Mask = DIndex.size() - 1;
+            std::size_t Slot = Hash(DAttributes[index].first) & Mask;
+            while(DIndex[Slot]){
+                // Keep the first attribute with a name like a linear search would
+                if(DAttributes[DIndex[Slot] - 1].first == DAttributes[index].first){
+                    return;
+                }
+                Slot = (Slot + 1) & Mask;
+            }
+            DIndex[Slot] = uint32_t(index + 1);
+        };
+
+        void Reindex(){
+            std::size_t Slots = 4 * IndexThreshold;
+            while(Slots < 2 * DCount){
+                Slots *= 2;
+            }
+            DIndex.assign(Slots, 0);
+            for(size_type Index = 0; Index < DCount; Index++){
+                IndexAttribute(Index);
+            }
+        };
+
+        // Returns the next spare attribute, adding one if there is none
+        TAttribute &Append(){
+            if(DCount == DAttributes.size()){
+                DAttributes.emplace_back();
+            }
+            return DAttributes[DCount++];
+        };
+
+        // Returns the index of the first attribute with name, or DCount if
+        // there is none
+        size_type FindIndex(std::string_view name) const{
+            if(DIndex.empty()){
+                for(size_type Index = 0; Index < DCount; Index++){
+                    if(DAttributes[Index].first == name){
+                        return Index;
+                    }
+                }
+                return DCount;
+            }
+            std::size_t Mask = DIndex.size() - 1;
+            for(std::size_t Slot = Hash(name) & Mask; DIndex[Slot]; Slot = (Slot + 1) & Mask){
+                if(DAttributes[DIndex[Slot] - 1].first == name){
+                    return DIndex[Slot] - 1;
+                }
+            }
+            return DCount;
+        };
+
+        void Appended(){
+            if(DCount <= IndexThreshold){
+                return;
+            }
+            if(DIndex.size() < 2 * DCount){
+                Reindex();
+            }
+            else{
+                IndexAttribute(DCount - 1);
+            }
+        };
+
+    public:
+        CXMLAttributeList() = default;
+
+        CXMLAttributeList(std::initializer_list< TAttribute > attributes){
+            for(auto &Attribute : attributes){
+                push_back(Attribute);
+            }
+        };
+
+        CXMLAttributeList(const CXMLAttributeList &list) : DAttributes(list.begin(), list.end()), DCount(list.DCount), DIndex(list.DIndex){
+
+        };
+
+        // A moved from list is left empty
+        CXMLAttributeList(CXMLAttributeList &&list) noexcept : DAttributes(std::move(list.DAttributes)), DCount(list.DCount), DIndex(std::move(list.DIndex)){
+            list.DCount = 0;
+            list.DAttributes.clear();
+            list.DIndex.clear();
+        };
+
+        CXMLAttributeList &operator=(const CXMLAttributeList &list){
+            if(this != &list){
+                Assign(list.size(), [&](size_type index){
+                    return std::make_pair(std::string_view(list[index].first), std::string_view(list[index].second));
+                });
+            }
+            return *this;
+        };
+
+        CXMLAttributeList &operator=(CXMLAttributeList &&list) noexcept{
+            if(this != &list){
+                DAttributes = std::move(list.DAttributes);
+                DCount = list.DCount;
+                DIndex = std::move(list.DIndex);
+                list.DCount = 0;
+                list.DAttributes.clear();
+                list.DIndex.clear();
+            }
+            return *this;
+        };
+
+        size_type size() const{
+            return DCount;
+        };
+
+        bool empty() const{
+            return DCount == 0;
+        };
+
+        const TAttribute &operator[](size_type index) const{
+            return DAttributes[index];
+        };
+
+        const_iterator begin() const{
+            return DAttributes.begin();
+        };
+
+        const_iterator end() const{
+            return DAttributes.begin() + DCount;
+        };
+
+        void reserve(size_type count){
+            DAttributes.reserve(count);
+        };
+
+        void clear(){
+            DCount = 0;
+            DIndex.clear();
+        };
+
+        void push_back(const TAttribute &attribute){
+            Append() = attribute;
+            Appended();
+        };
+
+        template <typename TName, typename TValue> void emplace_back(TName &&name, TValue &&value){
+            TAttribute &Attribute = Append();
+            Attribute.first = std::forward<TName>(name);
+            Attribute.second = std::forward<TValue>(value);
+            Appended();
+        };
+
+        const TAttribute *Find(std::string_view name) const{
+            size_type Index = FindIndex(name);
+            return Index < DCount ? &DAttributes[Index] : nullptr;
+        };
+
+        // Replaces the contents with count attributes, where source(index)
+        // returns the name and value of each. The strings already in the list
+        // are assigned to so their capacity is reused.
+        template <typename TSource> void Assign(size_type count, TSource source){
+            if(DAttributes.size() < count){
+                DAttributes.resize(count);
+            }
+            DCount = count;
+            for(size_type Index = 0; Index < count; Index++){
+                auto [Name, Value] = source(Index);
+                DAttributes[Index].first.assign(Name.data(), Name.size());
+                DAttributes[Index].second.assign(Value.data(), Value.size());
+            }
+            if(count > IndexThreshold){
+                Reindex();
+            }
+            else{
+                DIndex.clear();
+            }
+        };
+
+        // Replaces the value of an existing attribute or appends a new one
+        void Set(std::string_view name, std::string_view value){
+            size_type Index = FindIndex(name);
+            if(Index < DCount){
+                DAttributes[Index].second = value;
+            }
+            else{
+                emplace_back(name, value);
+            }
+        };
+};
+
 struct SXMLEntity{
-    using TAttribute = std::pair< std::string, std::string >;
+    using TAttribute = CXMLAttributeList::TAttribute;
     enum class EType{StartElement, EndElement, CharData, CompleteElement};
     EType DType;
     std::string DNameData;
-    std::vector< TAttribute > DAttributes;
-    
-    bool AttributeExists(const std::string &name) const{
-        for(auto &Attribute : DAttributes){
-            if(std::get<0>(Attribute) == name){
-                return true;   
-            }
-        }
-        return false;
+    CXMLAttributeList DAttributes;
+
+    bool AttributeExists(std::string_view name) const{
+        return DAttributes.Find(name) != nullptr;
     };
-    
-    std::string AttributeValue(const std::string &name) const{
-        for(auto &Attribute : DAttributes){
-            if(std::get<0>(Attribute) == name){
-                return std::get<1>(Attribute);   
-            }
-        }
-        return std::string();
+
+    // Returns an empty string if the attribute does not exist
+    const std::string &AttributeValue(std::string_view name) const{
+        static const std::string EmptyValue;
+        auto Attribute = DAttributes.Find(name);
+        return Attribute ? Attribute->second : EmptyValue;
     };
-    
-    bool SetAttribute(const std::string &name, const std::string &value){
+
+    bool SetAttribute(std::string_view name, std::string_view value){
         if(name.empty()){
-            return false;   
+            return false;
         }
-        for(std::vector< TAttribute >::size_type Index = 0; Index < DAttributes.size(); Index++){
-            if(std::get<0>(DAttributes[Index]) == name){
-                DAttributes[Index] = std::make_pair(name,value);
-                return true;
-            }
-        }
-        DAttributes.push_back(std::make_pair(name,value));
+        DAttributes.Set(name, value);
         return true;
     };
 };
-   
+
 #endif
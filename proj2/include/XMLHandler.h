@@ -0,0 +1,26 @@
+#ifndef XMLHANDLER_H
+#define XMLHANDLER_H
+
+#include <string_view>
+#include <vector>
+
+struct SXMLAttributeView{
+    std::string_view DName;
+    std::string_view DValue;
+};
+
+// Receives the parse events of CXMLReader::Parse straight from the expat
+// callbacks. Element and attribute names are interned in the reader's
+// CXMLNameTable and live as long as the reader, attribute values and
+// character data point into the parser's memory and are only valid for the
+// duration of the call.
+class CXMLHandler{
+    public:
+        virtual ~CXMLHandler(){};
+        virtual void OnStart(std::string_view /*name*/, const std::vector< SXMLAttributeView > &/*attributes*/){};
+        virtual void OnEnd(std::string_view /*name*/){};
+        // Character data may be split over several consecutive calls
+        virtual void OnCharData(std::string_view /*data*/){};
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef XMLNAMETABLE_H
+#define XMLNAMETABLE_H
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "XMLEntity.h"
+
+// Stores one copy of each element and attribute name. Interned names stay
+// valid for the lifetime of the table, and two interned names are equal
+// exactly when their data pointers are, so names can be compared without
+// looking at their characters.
+class CXMLNameTable{
+    private:
+        std::deque< std::string > DStorage;
+        std::unordered_set< std::string_view > DIndex;
+
+    public:
+        std::string_view Intern(std::string_view name);
+        // Returns the interned name, or an empty view if name was never interned
+        std::string_view Find(std::string_view name) const;
+        std::size_t Size() const;
+};
+
+// Entity whose element and attribute names are interned in the reader's
+// CXMLNameTable, character data is held in DData
+struct SXMLInternedEntity{
+    using TAttribute = std::pair< std::string_view, std::string >;
+    SXMLEntity::EType DType;
+    std::string_view DName;
+    std::string DData;
+    std::vector< TAttribute > DAttributes;
+
+    // name must be interned in the same table
+    const std::string *AttributeValue(std::string_view name) const{
+        for(auto &Attribute : DAttributes){
+            if(Attribute.first.data() == name.data()){
+                return &Attribute.second;
+            }
+        }
+        return nullptr;
+    };
+};
+
+#endif
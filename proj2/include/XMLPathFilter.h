@@ -0,0 +1,52 @@
+#ifndef XMLPATHFILTER_H
+#define XMLPATHFILTER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "XMLEntity.h"
+#include "XMLHandler.h"
+
+// Handler that only passes on the subtrees of elements matching a path such
+// as /osm/node[@type='x']/tag. A path is a list of child steps from the
+// document root, each step is an element name or * followed by any number of
+// [@name] or [@name='value'] predicates. The open elements are tracked as
+// the number of leading steps they match, so the events inside unmatched
+// subtrees are dropped without looking at them further.
+class CXMLPathFilter : public CXMLHandler{
+    private:
+        struct SPredicate{
+            std::string DName;
+            std::string DValue;
+            bool DHasValue;
+        };
+
+        struct SStep{
+            std::string DName;
+            std::vector< SPredicate > DPredicates;
+        };
+
+        CXMLHandler &DHandler;
+        std::vector< SStep > DSteps;
+        bool DValid;
+        // Depth of the current element, the first DMatched open elements
+        // match the first DMatched steps
+        std::size_t DDepth = 0;
+        std::size_t DMatched = 0;
+
+        bool StepMatches(const SStep &step, std::string_view name, const std::vector< SXMLAttributeView > &attributes) const;
+
+    public:
+        // Matched events are passed to handler, which must outlive the filter
+        CXMLPathFilter(const std::string &path, CXMLHandler &handler);
+
+        // Returns false if the path could not be compiled, nothing matches then
+        bool Valid() const;
+        // Returns true while the events are inside a matched subtree
+        bool Matching() const;
+        void OnStart(std::string_view name, const std::vector< SXMLAttributeView > &attributes) override;
+        void OnEnd(std::string_view name) override;
+        void OnCharData(std::string_view data) override;
+};
+
+#endif
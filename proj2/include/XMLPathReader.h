@@ -0,0 +1,26 @@
+#ifndef XMLPATHREADER_H
+#define XMLPATHREADER_H
+
+#include <memory>
+#include <string>
+#include "DataSource.h"
+#include "XMLEntity.h"
+
+// Reads the entities of the subtrees matching a CXMLPathFilter path. The
+// document is parsed in handler mode, only matched events are turned into
+// SXMLEntity objects.
+class CXMLPathReader{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        CXMLPathReader(std::shared_ptr< CDataSource > src, const std::string &path, std::size_t chunksize = 65536);
+        ~CXMLPathReader();
+
+        bool Valid() const;
+        bool End() const;
+        bool ReadEntity(SXMLEntity &entity, bool skipcdata = false);
+};
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <memory>
 #include "XMLEntity.h"
+#include "XMLHandler.h"
+#include "XMLNameTable.h"
 #include "DataSource.h"
 
 class CXMLReader{
@@ -11,11 +13,23 @@ class CXMLReader{
         std::unique_ptr<SImplementation> DImplementation;
         
     public:
-        CXMLReader(std::shared_ptr< CDataSource > src);
+        // Input is read and parsed chunksize bytes at a time
+        CXMLReader(std::shared_ptr< CDataSource > src, std::size_t chunksize = 65536);
         ~CXMLReader();
         
         bool End() const;
         bool ReadEntity(SXMLEntity &entity, bool skipcdata = false);
+        // Same as ReadEntity, but the names are interned in NameTable()
+        bool ReadEntity(SXMLInternedEntity &entity, bool skipcdata = false);
+        // Names in entities and handler calls come from this table, interning
+        // a name up front allows comparing against it by pointer
+        CXMLNameTable &NameTable();
+        // Parses the rest of the document, calling handler directly from the
+        // parser instead of queueing entities. Returns false on a parse error.
+        bool Parse(CXMLHandler &handler);
+        // Like Parse, but only parses the next chunk of input. Returns false
+        // once the document is finished or on a parse error.
+        bool ParseNext(CXMLHandler &handler);
 };
 
 #endif
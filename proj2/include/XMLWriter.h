@@ -11,7 +11,21 @@ class CXMLWriter{
         std::unique_ptr<SImplementation> DImplementation;
         
     public:
-        CXMLWriter(std::shared_ptr< CDataSink > sink);
+        // Raw writes the entities exactly as given. Indented puts each
+        // element on its own line indented by two spaces per level until its
+        // parent gets text, Compact drops whitespace only character data,
+        // and Canonical sorts the attributes, normalizes the whitespace of
+        // character data and writes empty elements as start and end tag
+        // pairs.
+        enum class EFormat{Raw, Indented, Compact, Canonical};
+
+        // Output is buffered until at least flushthreshold bytes are pending,
+        // the default of zero writes every entity to the sink immediately.
+        // With collapseempty a start element directly followed by its end
+        // element is written as <name/>, the '>' of each start tag is then
+        // only written once the next entity or Flush shows it is needed. It
+        // is off by default so every entity reaches the sink complete.
+        CXMLWriter(std::shared_ptr< CDataSink > sink, std::size_t flushthreshold = 0, EFormat format = EFormat::Raw, bool collapseempty = false);
         ~CXMLWriter();
         
         bool Flush();
@@ -0,0 +1,51 @@
+#include "ColumnBatch.h"
+
+std::string_view CColumnBatch::SColumn::Value(std::size_t row) const{
+    return std::string_view(DData.data() + DOffsets[row], DOffsets[row + 1] - DOffsets[row]);
+}
+
+std::size_t CColumnBatch::RowCount() const{
+    return DRowCount;
+}
+
+std::size_t CColumnBatch::ColumnCount() const{
+    return DColumnCount;
+}
+
+const CColumnBatch::SColumn &CColumnBatch::Column(std::size_t column) const{
+    return DColumns[column];
+}
+
+std::string_view CColumnBatch::Value(std::size_t column, std::size_t row) const{
+    return DColumns[column].Value(row);
+}
+
+void CColumnBatch::Clear(){
+    for(std::size_t Index = 0; Index < DColumnCount; Index++){
+        DColumns[Index].DData.clear();
+        DColumns[Index].DOffsets.resize(1);
+    }
+    DColumnCount = 0;
+    DRowCount = 0;
+}
+
+void CColumnBatch::AppendRow(const std::vector< std::string_view > &row){
+    if(row.size() > DColumnCount){
+        if(DColumns.size() < row.size()){
+            DColumns.resize(row.size());
+        }
+        for(std::size_t Index = DColumnCount; Index < row.size(); Index++){
+            DColumns[Index].DData.clear();
+            DColumns[Index].DOffsets.assign(DRowCount + 1, 0);
+        }
+        DColumnCount = row.size();
+    }
+    for(std::size_t Index = 0; Index < DColumnCount; Index++){
+        SColumn &Column = DColumns[Index];
+        if(Index < row.size()){
+            Column.DData.insert(Column.DData.end(), row[Index].begin(), row[Index].end());
+        }
+        Column.DOffsets.push_back(Column.DData.size());
+    }
+    DRowCount++;
+}
@@ -0,0 +1,213 @@
+#include "CompressedDataSink.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+#ifdef COMPRESSION_ZSTD
+#include <zstd.h>
+#endif
+
+struct CCompressedDataSink::SImplementation{
+    enum class EMode{Continue, Flush, Finish};
+
+    std::shared_ptr< CDataSink > DSink;
+    ECompressionFormat DFormat;
+    // Input not yet compressed is DInput[0, DInputLength)
+    std::vector< char > DInput;
+    std::size_t DInputLength = 0;
+    std::vector< char > DOutput;
+    bool DOpen = false;
+    bool DFinished = false;
+    bool DError = false;
+    z_stream DZStream;
+#ifdef COMPRESSION_ZSTD
+    ZSTD_CCtx *DZstdContext = nullptr;
+#endif
+
+    SImplementation(std::shared_ptr< CDataSink > sink, ECompressionFormat format, int level, int windowbits, std::size_t blocksize)
+        : DSink(sink), DFormat(format){
+        DInput.resize(std::max<std::size_t>(blocksize, 1));
+        DOutput.resize(std::max<std::size_t>(blocksize, 4096));
+        if((DFormat == ECompressionFormat::Gzip) || (DFormat == ECompressionFormat::Zlib)){
+            std::memset(&DZStream, 0, sizeof(DZStream));
+            int WindowBits = windowbits ? std::min(std::max(windowbits, 9), 15) : 15;
+            // Adding 16 to the window bits selects the gzip wrapper
+            if(DFormat == ECompressionFormat::Gzip){
+                WindowBits += 16;
+            }
+            int Level = level == CompressionDefaultLevel ? Z_DEFAULT_COMPRESSION : std::min(std::max(level, -1), 9);
+            DOpen = deflateInit2(&DZStream, Level, Z_DEFLATED, WindowBits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        }
+        else if(DFormat == ECompressionFormat::Zstd){
+#ifdef COMPRESSION_ZSTD
+            DZstdContext = ZSTD_createCCtx();
+            DOpen = DZstdContext != nullptr;
+            if(DOpen){
+                int Level = level == CompressionDefaultLevel ? ZSTD_CLEVEL_DEFAULT : std::min(std::max(level, ZSTD_minCLevel()), ZSTD_maxCLevel());
+                ZSTD_CCtx_setParameter(DZstdContext, ZSTD_c_compressionLevel, Level);
+                if(windowbits){
+                    int Minimum = ZSTD_cParam_getBounds(ZSTD_c_windowLog).lowerBound;
+                    ZSTD_CCtx_setParameter(DZstdContext, ZSTD_c_windowLog, std::min(std::max(windowbits, Minimum), CompressionZstdMaxWindowLog));
+                }
+            }
+#endif
+        }
+        else{
+            DOpen = DFormat == ECompressionFormat::None;
+        }
+        DError = !DOpen;
+    }
+
+    ~SImplementation(){
+        Finish();
+        if(DOpen && ((DFormat == ECompressionFormat::Gzip) || (DFormat == ECompressionFormat::Zlib))){
+            deflateEnd(&DZStream);
+        }
+#ifdef COMPRESSION_ZSTD
+        ZSTD_freeCCtx(DZstdContext);
+#endif
+    }
+
+    bool WriteOutput(std::size_t length){
+        if(length && !DSink->WriteBlock(DOutput.data(), length)){
+            DError = true;
+        }
+        return !DError;
+    }
+
+    // Compresses data and writes the output to the sink
+    bool Compress(const char *data, std::size_t length, EMode mode){
+        if(DError){
+            return false;
+        }
+        if(DFormat == ECompressionFormat::None){
+            if(length && !DSink->WriteBlock(data, length)){
+                DError = true;
+            }
+            return !DError;
+        }
+        if(DFormat != ECompressionFormat::Zstd){
+            int Flush = mode == EMode::Finish ? Z_FINISH : mode == EMode::Flush ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+            // avail_in and avail_out are only 32 bits wide, larger buffers
+            // are fed a slice at a time
+            std::size_t OutputSize = std::min<std::size_t>(DOutput.size(), UINT_MAX);
+            std::size_t Unfed = length;
+            DZStream.next_in = reinterpret_cast< Bytef * >(const_cast< char * >(data));
+            DZStream.avail_in = 0;
+            while(true){
+                if(!DZStream.avail_in && Unfed){
+                    DZStream.avail_in = static_cast< uInt >(std::min<std::size_t>(Unfed, UINT_MAX));
+                    Unfed -= DZStream.avail_in;
+                }
+                DZStream.next_out = reinterpret_cast< Bytef * >(DOutput.data());
+                DZStream.avail_out = static_cast< uInt >(OutputSize);
+                int Result = deflate(&DZStream, Unfed ? Z_NO_FLUSH : Flush);
+                if((Result == Z_STREAM_ERROR) || !WriteOutput(OutputSize - DZStream.avail_out)){
+                    DError = true;
+                    return false;
+                }
+                if(!Unfed && (mode == EMode::Finish ? Result == Z_STREAM_END : DZStream.avail_out != 0)){
+                    return true;
+                }
+            }
+        }
+#ifdef COMPRESSION_ZSTD
+        ZSTD_EndDirective Directive = mode == EMode::Finish ? ZSTD_e_end : mode == EMode::Flush ? ZSTD_e_flush : ZSTD_e_continue;
+        ZSTD_inBuffer Input = {data, length, 0};
+        while(true){
+            ZSTD_outBuffer Output = {DOutput.data(), DOutput.size(), 0};
+            std::size_t Remaining = ZSTD_compressStream2(DZstdContext, &Output, &Input, Directive);
+            if(ZSTD_isError(Remaining) || !WriteOutput(Output.pos)){
+                DError = true;
+                return false;
+            }
+            if(mode == EMode::Continue ? Input.pos == Input.size : Remaining == 0){
+                return true;
+            }
+        }
+#else
+        DError = true;
+        return false;
+#endif
+    }
+
+    bool WriteBlock(const char *buf, std::size_t count){
+        if(DError || DFinished){
+            return false;
+        }
+        if(!DInputLength && (count >= DInput.size())){
+            return Compress(buf, count, EMode::Continue);
+        }
+        while(count){
+            std::size_t Length = std::min(count, DInput.size() - DInputLength);
+            std::memcpy(DInput.data() + DInputLength, buf, Length);
+            DInputLength += Length;
+            buf += Length;
+            count -= Length;
+            if(DInputLength == DInput.size()){
+                DInputLength = 0;
+                if(!Compress(DInput.data(), DInput.size(), EMode::Continue)){
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool CompressPending(EMode mode){
+        std::size_t Length = DInputLength;
+        DInputLength = 0;
+        return Compress(DInput.data(), Length, mode);
+    }
+
+    bool Flush(){
+        if(DFinished){
+            return !DError && DSink->Flush();
+        }
+        bool Result = CompressPending(EMode::Flush);
+        return DSink->Flush() && Result;
+    }
+
+    bool Finish(){
+        if(DFinished){
+            return !DError;
+        }
+        DFinished = true;
+        bool Result = CompressPending(EMode::Finish);
+        return DSink->Flush() && Result;
+    }
+};
+
+CCompressedDataSink::CCompressedDataSink(std::shared_ptr< CDataSink > sink, ECompressionFormat format, int level, int windowbits, std::size_t blocksize)
+    : DImplementation(std::make_unique<SImplementation>(sink, format, level, windowbits, blocksize)){
+
+}
+
+CCompressedDataSink::~CCompressedDataSink(){
+
+}
+
+bool CCompressedDataSink::IsOpen() const noexcept{
+    return DImplementation->DOpen;
+}
+
+bool CCompressedDataSink::Finish() noexcept{
+    return DImplementation->Finish();
+}
+
+bool CCompressedDataSink::Put(const char &ch) noexcept{
+    return DImplementation->WriteBlock(&ch, 1);
+}
+
+bool CCompressedDataSink::Write(const std::vector<char> &buf) noexcept{
+    return DImplementation->WriteBlock(buf.data(), buf.size());
+}
+
+bool CCompressedDataSink::WriteBlock(const char *buf, std::size_t count) noexcept{
+    return DImplementation->WriteBlock(buf, count);
+}
+
+bool CCompressedDataSink::Flush() noexcept{
+    return DImplementation->Flush();
+}
@@ -0,0 +1,320 @@
+#include "CompressedDataSource.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <zlib.h>
+#ifdef COMPRESSION_ZSTD
+#include <zstd.h>
+#endif
+
+struct CCompressedDataSource::SImplementation{
+    // Number of decompressed blocks the background thread may run ahead
+    static constexpr std::size_t DQueueDepth = 4;
+    static constexpr std::size_t DInputSize = 256 * 1024;
+
+    std::shared_ptr< CDataSource > DSource;
+    ECompressionFormat DFormat;
+    std::size_t DBlockSize;
+    bool DBackground;
+    std::atomic< bool > DError{false};
+
+    // Decoder state, only used by the thread that decompresses. Compressed
+    // input not yet consumed is DInput[DInputBegin, DInputEnd).
+    std::vector< char > DInput;
+    std::size_t DInputBegin = 0;
+    std::size_t DInputEnd = 0;
+    bool DSourceEnd = false;
+    // True while the decoder is inside a gzip member or zstd frame
+    bool DStreamOpen = false;
+    bool DDecodeEnd = false;
+    z_stream DZStream;
+    bool DZStreamInitialized = false;
+#ifdef COMPRESSION_ZSTD
+    ZSTD_DStream *DZstdStream = nullptr;
+#endif
+
+    // Decompressed block being read
+    std::vector< char > DCurrent;
+    std::size_t DCurrentIndex = 0;
+    bool DEnd = false;
+
+    // Blocks handed from the background thread to the reader, and emptied
+    // blocks handed back so their memory is reused
+    std::mutex DMutex;
+    std::condition_variable DChanged;
+    std::deque< std::vector< char > > DReady;
+    std::vector< std::vector< char > > DSpare;
+    bool DFinished = false;
+    bool DStop = false;
+    std::thread DThread;
+
+    SImplementation(std::shared_ptr< CDataSource > src, ECompressionFormat format, bool background, std::size_t blocksize)
+        : DSource(src), DFormat(format), DBlockSize(std::max<std::size_t>(blocksize, 1)), DBackground(background){
+        DInput.resize(DInputSize);
+        if(DFormat == ECompressionFormat::Auto){
+            DetectFormat();
+        }
+        if(!InitializeDecoder()){
+            DError = true;
+            DDecodeEnd = true;
+            DEnd = true;
+            return;
+        }
+        if(DBackground){
+            DThread = std::thread(&SImplementation::Run, this);
+        }
+    }
+
+    ~SImplementation(){
+        if(DThread.joinable()){
+            {
+                std::lock_guard< std::mutex > Lock(DMutex);
+                DStop = true;
+            }
+            DChanged.notify_all();
+            DThread.join();
+        }
+        if(DZStreamInitialized){
+            inflateEnd(&DZStream);
+        }
+#ifdef COMPRESSION_ZSTD
+        ZSTD_freeDStream(DZstdStream);
+#endif
+    }
+
+    // Raw zlib streams have too weak a header to tell them from plain text,
+    // so only gzip and zstd are recognized
+    void DetectFormat(){
+        while((DInputEnd < 4) && !DSourceEnd){
+            std::size_t Length = DSource->ReadBlock(DInput.data() + DInputEnd, DInput.size() - DInputEnd);
+            DSourceEnd = !Length;
+            DInputEnd += Length;
+        }
+        auto Byte = [&](std::size_t index){
+            return index < DInputEnd ? static_cast< unsigned char >(DInput[index]) : 0u;
+        };
+        if((Byte(0) == 0x1F) && (Byte(1) == 0x8B)){
+            DFormat = ECompressionFormat::Gzip;
+        }
+        else if((Byte(0) == 0x28) && (Byte(1) == 0xB5) && (Byte(2) == 0x2F) && (Byte(3) == 0xFD)){
+            DFormat = ECompressionFormat::Zstd;
+        }
+        else{
+            DFormat = ECompressionFormat::None;
+        }
+    }
+
+    bool InitializeDecoder(){
+        if((DFormat == ECompressionFormat::Gzip) || (DFormat == ECompressionFormat::Zlib)){
+            std::memset(&DZStream, 0, sizeof(DZStream));
+            // 32 lets zlib accept both gzip and zlib headers
+            DZStreamInitialized = inflateInit2(&DZStream, 15 + 32) == Z_OK;
+            return DZStreamInitialized;
+        }
+        if(DFormat == ECompressionFormat::Zstd){
+#ifdef COMPRESSION_ZSTD
+            DZstdStream = ZSTD_createDStream();
+            return DZstdStream && !ZSTD_isError(ZSTD_initDStream(DZstdStream))
+                && !ZSTD_isError(ZSTD_DCtx_setParameter(DZstdStream, ZSTD_d_windowLogMax, CompressionZstdMaxWindowLog));
+#else
+            return false;
+#endif
+        }
+        return DFormat == ECompressionFormat::None;
+    }
+
+    // Makes sure compressed input is available, returns false once the
+    // underlying source is exhausted
+    bool RefillInput(){
+        if(DInputBegin < DInputEnd){
+            return true;
+        }
+        if(DSourceEnd){
+            return false;
+        }
+        DInputBegin = 0;
+        DInputEnd = DSource->ReadBlock(DInput.data(), DInput.size());
+        DSourceEnd = !DInputEnd;
+        return DInputEnd > 0;
+    }
+
+    // Decompresses into out, returns less than capacity only at the end of
+    // the input or on an error
+    std::size_t Decode(char *out, std::size_t capacity){
+        std::size_t Produced = 0;
+        while((Produced < capacity) && !DDecodeEnd && !DError){
+            bool HaveInput = RefillInput();
+            if(!HaveInput && !DStreamOpen){
+                DDecodeEnd = true;
+                break;
+            }
+            std::size_t Available = DInputEnd - DInputBegin;
+            std::size_t Before = Produced;
+            if(DFormat == ECompressionFormat::None){
+                std::size_t Length = std::min(Available, capacity - Produced);
+                std::memcpy(out + Produced, DInput.data() + DInputBegin, Length);
+                DInputBegin += Length;
+                Produced += Length;
+            }
+            else if(DZStreamInitialized){
+                // avail_in and avail_out are only 32 bits wide, the loop
+                // hands larger buffers over a slice at a time
+                uInt InputSlice = static_cast< uInt >(std::min<std::size_t>(Available, UINT_MAX));
+                uInt OutputSlice = static_cast< uInt >(std::min<std::size_t>(capacity - Produced, UINT_MAX));
+                DZStream.next_in = reinterpret_cast< Bytef * >(DInput.data() + DInputBegin);
+                DZStream.avail_in = InputSlice;
+                DZStream.next_out = reinterpret_cast< Bytef * >(out + Produced);
+                DZStream.avail_out = OutputSlice;
+                int Result = inflate(&DZStream, Z_NO_FLUSH);
+                DInputBegin += InputSlice - DZStream.avail_in;
+                Produced += OutputSlice - DZStream.avail_out;
+                DStreamOpen = DStreamOpen || (InputSlice != DZStream.avail_in);
+                if(Result == Z_STREAM_END){
+                    // Concatenated gzip members decompress as one stream
+                    DStreamOpen = false;
+                    inflateReset(&DZStream);
+                }
+                else if((Result != Z_OK) && (Result != Z_BUF_ERROR)){
+                    DError = true;
+                }
+            }
+#ifdef COMPRESSION_ZSTD
+            else{
+                ZSTD_inBuffer Input = {DInput.data() + DInputBegin, Available, 0};
+                ZSTD_outBuffer Output = {out + Produced, capacity - Produced, 0};
+                std::size_t Result = ZSTD_decompressStream(DZstdStream, &Output, &Input);
+                if(ZSTD_isError(Result)){
+                    DError = true;
+                }
+                DInputBegin += Input.pos;
+                Produced += Output.pos;
+                DStreamOpen = Result != 0;
+            }
+#endif
+            if(!HaveInput && (Produced == Before)){
+                // The input ends in the middle of a member or frame
+                DError = true;
+            }
+        }
+        return Produced;
+    }
+
+    void Run(){
+        while(true){
+            std::vector< char > Block;
+            {
+                std::unique_lock< std::mutex > Lock(DMutex);
+                DChanged.wait(Lock, [&]{ return DStop || (DReady.size() < DQueueDepth); });
+                if(DStop){
+                    return;
+                }
+                if(!DSpare.empty()){
+                    Block = std::move(DSpare.back());
+                    DSpare.pop_back();
+                }
+            }
+            Block.resize(DBlockSize);
+            Block.resize(Decode(Block.data(), Block.size()));
+            std::lock_guard< std::mutex > Lock(DMutex);
+            if(Block.empty()){
+                DFinished = true;
+                DChanged.notify_all();
+                return;
+            }
+            DReady.push_back(std::move(Block));
+            DChanged.notify_all();
+        }
+    }
+
+    // Makes sure at least one decompressed byte is available
+    bool Fill(){
+        if(DCurrentIndex < DCurrent.size()){
+            return true;
+        }
+        if(DEnd){
+            return false;
+        }
+        DCurrentIndex = 0;
+        if(!DBackground){
+            DCurrent.resize(DBlockSize);
+            DCurrent.resize(Decode(DCurrent.data(), DCurrent.size()));
+            DEnd = DCurrent.empty();
+            return !DEnd;
+        }
+        std::unique_lock< std::mutex > Lock(DMutex);
+        DSpare.push_back(std::move(DCurrent));
+        DCurrent.clear();
+        DChanged.wait(Lock, [&]{ return !DReady.empty() || DFinished; });
+        if(DReady.empty()){
+            DEnd = true;
+            return false;
+        }
+        DCurrent = std::move(DReady.front());
+        DReady.pop_front();
+        DChanged.notify_all();
+        return true;
+    }
+
+    std::size_t ReadBlock(char *buf, std::size_t count){
+        std::size_t Total = 0;
+        while((Total < count) && Fill()){
+            std::size_t Length = std::min(count - Total, DCurrent.size() - DCurrentIndex);
+            std::memcpy(buf + Total, DCurrent.data() + DCurrentIndex, Length);
+            DCurrentIndex += Length;
+            Total += Length;
+        }
+        return Total;
+    }
+};
+
+CCompressedDataSource::CCompressedDataSource(std::shared_ptr< CDataSource > src, ECompressionFormat format, bool background, std::size_t blocksize)
+    : DImplementation(std::make_unique<SImplementation>(src, format, background, blocksize)){
+
+}
+
+CCompressedDataSource::~CCompressedDataSource(){
+
+}
+
+ECompressionFormat CCompressedDataSource::Format() const noexcept{
+    return DImplementation->DFormat;
+}
+
+bool CCompressedDataSource::Error() const noexcept{
+    return DImplementation->DError;
+}
+
+bool CCompressedDataSource::End() const noexcept{
+    return !DImplementation->Fill();
+}
+
+bool CCompressedDataSource::Get(char &ch) noexcept{
+    if(!DImplementation->Fill()){
+        return false;
+    }
+    ch = DImplementation->DCurrent[DImplementation->DCurrentIndex++];
+    return true;
+}
+
+bool CCompressedDataSource::Peek(char &ch) noexcept{
+    if(!DImplementation->Fill()){
+        return false;
+    }
+    ch = DImplementation->DCurrent[DImplementation->DCurrentIndex];
+    return true;
+}
+
+bool CCompressedDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    buf.resize(count);
+    buf.resize(DImplementation->ReadBlock(buf.data(), count));
+    return !buf.empty();
+}
+
+std::size_t CCompressedDataSource::ReadBlock(char *buf, std::size_t count) noexcept{
+    return DImplementation->ReadBlock(buf, count);
+}
@@ -1,76 +1,237 @@
 #include "DSVReader.h"
 #include "DataSource.h"
-#include "StringDataSource.h"
+#include "DSVScanner.h"
 #include <vector>
 #include <string>
-#include <sstream> 
+#include <string_view>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <memory>
 
 struct CDSVReader::SImplementation {
+    static constexpr std::size_t InitialBufferSize = 65536;
+
     char delimiter;
+    std::size_t maxRowSize;
     std::shared_ptr<CDataSource> dc;
-    
-    SImplementation(std::shared_ptr<CDataSource> dc, char delimiter)
-        : delimiter(delimiter == '"' ? ',' : delimiter), dc(dc) {}
-    
-    bool End() const {
-        char a;
-        return !dc->Peek(a);
+    // Unconsumed input lives in buffer[bufferStart, bufferEnd)
+    std::vector<char> buffer;
+    std::size_t bufferStart = 0;
+    std::size_t bufferEnd = 0;
+    bool sourceEnd = false;
+    // Field views reused by ReadRow
+    std::vector<std::string_view> views;
+    // Delimiter offsets within the current row
+    std::vector<std::size_t> delimiters;
+    // Column types for ReadTypedRow and the columns that are not skipped
+    std::vector<EColumnType> schema;
+    std::vector<std::size_t> projection;
+
+    SImplementation(std::shared_ptr<CDataSource> dc, char delimiter, std::size_t maxrowsize)
+        : delimiter(delimiter == '"' ? ',' : delimiter), maxRowSize(maxrowsize), dc(dc), buffer(InitialBufferSize) {}
+
+    // Moves the unconsumed bytes to the front of the buffer and reads more
+    // input behind them, growing the buffer if a single row fills it
+    bool FillBuffer() {
+        if (sourceEnd) {
+            return false;
+        }
+        if (bufferStart) {
+            std::memmove(buffer.data(), buffer.data() + bufferStart, bufferEnd - bufferStart);
+            bufferEnd -= bufferStart;
+            bufferStart = 0;
+        }
+        if (bufferEnd == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+        std::size_t length = dc->ReadBlock(buffer.data() + bufferEnd, buffer.size() - bufferEnd);
+        if (!length) {
+            sourceEnd = true;
+            return false;
+        }
+        bufferEnd += length;
+        return true;
     }
-    
-    bool ReadRow(std::vector<std::string>& row) {
+
+    bool End() {
+        return (bufferStart == bufferEnd) && !FillBuffer();
+    }
+
+    // Finds the newline that terminates the row starting at bufferStart and
+    // returns its offset from bufferStart (or the remaining length at end of
+    // input), the offsets of the delimiters that separate the fields are
+    // left in delimiters. Past maxRowSize bytes a newline ends the row even
+    // inside a quoted field.
+    std::size_t FindRowEnd() {
+        delimiters.clear();
+        std::size_t offset = 0;
+        DSVScanner::SScanState state;
+        state.DMaxRowSize = maxRowSize;
+        while (true) {
+            std::size_t length = bufferEnd - bufferStart;
+            offset = DSVScanner::FindRowEnd(buffer.data() + bufferStart, offset, length, delimiter, state, delimiters);
+            if (offset < length || !FillBuffer()) {
+                return offset;
+            }
+        }
+    }
+
+    // Removes the quotes from a field and unescapes "" in place, the
+    // unquoted field is never longer than the raw one so the row's own bytes
+    // in the buffer serve as the scratch space. Only a quote at the start of
+    // the field opens a quoted section, after its closing quote the rest of
+    // the field is kept as is.
+    static std::string_view UnquoteField(char *begin, char *end) {
+        if ((begin == end) || (*begin != '"')) {
+            return std::string_view(begin, end - begin);
+        }
+        char *output = begin;
+        char *current = begin + 1;
+        for (; current < end; current++) {
+            if (*current != '"') {
+                *output++ = *current;
+            }
+            else if ((current + 1 < end) && (current[1] == '"')) {
+                // Escaped quote
+                *output++ = '"';
+                current++;
+            }
+            else {
+                current++;
+                break;
+            }
+        }
+        std::size_t rest = end - std::min(current, end);
+        std::memmove(output, current, rest);
+        return std::string_view(begin, output + rest - begin);
+    }
+
+    // A row holding a single empty field reads as no row, the same as an
+    // empty line
+    bool EmptyRow(const char *rowStart, const char *rowEnd) const {
+        std::size_t length = rowEnd - rowStart;
+        return delimiters.empty() && ((length == 0) || ((rowStart[0] == '"') && ((length == 1) || ((length == 2) && (rowStart[1] == '"')))));
+    }
+
+    // Consumes the next row, returning its start and end or false at the end
+    // of input. The delimiter offsets are left in delimiters and the bytes
+    // stay in place until the next FillBuffer call.
+    bool NextRow(char *&rowStart, char *&rowEnd) {
+        if (End()) {
+            return false;
+        }
+        std::size_t rowLength = FindRowEnd();
+        rowStart = buffer.data() + bufferStart;
+        rowEnd = rowStart + rowLength;
+        bufferStart += std::min(rowLength + 1, bufferEnd - bufferStart);
+        return true;
+    }
+
+    bool ReadRowView(std::vector<std::string_view>& row) {
         row.clear();
-        std::string val;
-        char a;
-        bool inQuotes = false;
-        
-        while (dc->Get(a)) {
-            if (a == '"') {
-                // Handle quotes
-                if (val.empty()) {
-                    inQuotes = true;
-                    continue;
-                }
-                char nextChar;
-                if (!dc->Get(nextChar) || nextChar == '\n') {
-                    break;
+        char *rowStart, *rowEnd;
+        if (!NextRow(rowStart, rowEnd)) {
+            return false;
+        }
+        if (!EmptyRow(rowStart, rowEnd)) {
+            char *current = rowStart;
+            for (std::size_t fieldEnd : delimiters) {
+                row.push_back(UnquoteField(current, rowStart + fieldEnd));
+                current = rowStart + fieldEnd + 1;
+            }
+            row.push_back(UnquoteField(current, rowEnd));
+        }
+        return !row.empty();
+    }
+
+    bool ReadRow(std::vector<std::string>& row) {
+        bool result = ReadRowView(views);
+        // Reuse the strings already in row to avoid reallocating them
+        row.resize(views.size());
+        for (std::size_t index = 0; index < views.size(); index++) {
+            row[index].assign(views[index].data(), views[index].size());
+        }
+        return result;
+    }
+
+    static void ParseField(STypedField& field, std::string_view value) {
+        const char *first = value.data();
+        const char *last = first + value.size();
+        switch (field.DType) {
+            case EColumnType::Int64: {
+                auto [end, error] = std::from_chars(first, last, field.DInt64);
+                field.DValid = (error == std::errc()) && (end == last);
+                break;
+            }
+            case EColumnType::Double: {
+                auto [end, error] = std::from_chars(first, last, field.DDouble);
+                field.DValid = (error == std::errc()) && (end == last);
+                break;
+            }
+            case EColumnType::Bool:
+                field.DValid = true;
+                if (value == "1" || value == "true" || value == "TRUE" || value == "True") {
+                    field.DBool = true;
                 }
-                if (nextChar == delimiter) {
-                    row.push_back(val);
-                    val.clear();
-                    inQuotes = false;
-                    continue;
+                else if (value == "0" || value == "false" || value == "FALSE" || value == "False") {
+                    field.DBool = false;
                 }
-                if (nextChar == '"') {
-                    val += a; // Escaped quote
-                    continue;
+                else {
+                    field.DValid = false;
                 }
-            }
-            else if (a == delimiter && !inQuotes) {
-                // Delimiter found outside quote, end field
-                row.push_back(val);
-                val.clear();
-            }
-            else if (a == '\n') {
-                // End of row
                 break;
+            default:
+                field.DString = value;
+                field.DValid = true;
+                break;
+        }
+    }
+
+    bool ReadTypedRow(std::vector<STypedField>& row) {
+        char *rowStart, *rowEnd;
+        if (!NextRow(rowStart, rowEnd)) {
+            row.clear();
+            return false;
+        }
+        row.resize(projection.size());
+        std::size_t fieldCount = EmptyRow(rowStart, rowEnd) ? 0 : delimiters.size() + 1;
+        for (std::size_t index = 0; index < projection.size(); index++) {
+            std::size_t column = projection[index];
+            STypedField& field = row[index];
+            field = STypedField{schema[column], false, 0, 0.0, false, std::string_view()};
+            if (column < fieldCount) {
+                char *fieldStart = column ? rowStart + delimiters[column - 1] + 1 : rowStart;
+                char *fieldEnd = column < delimiters.size() ? rowStart + delimiters[column] : rowEnd;
+                ParseField(field, UnquoteField(fieldStart, fieldEnd));
             }
-            else {
-                // Regular char added to field
-                val += a;
+        }
+        return fieldCount > 0;
+    }
+
+    void SetSchema(const std::vector<EColumnType>& columns) {
+        schema = columns;
+        projection.clear();
+        for (std::size_t index = 0; index < schema.size(); index++) {
+            if (schema[index] != EColumnType::Skip) {
+                projection.push_back(index);
             }
         }
-        
-        // Push last value if not empty or if row has other values
-        if (!val.empty() || !row.empty()) {
-            row.push_back(val);
+    }
+
+    bool ReadBatch(std::size_t maxRows, CColumnBatch& batch) {
+        batch.Clear();
+        while (batch.RowCount() < maxRows && !End()) {
+            if (ReadRowView(views)) {
+                batch.AppendRow(views);
+            }
         }
-        return !row.empty();
+        return batch.RowCount() > 0;
     }
 };
 
-CDSVReader::CDSVReader(std::shared_ptr<CDataSource> dc, char delimiter)
-    : DImplementation(std::make_unique<SImplementation>(dc, delimiter)) {}
+CDSVReader::CDSVReader(std::shared_ptr<CDataSource> dc, char delimiter, std::size_t maxrowsize)
+    : DImplementation(std::make_unique<SImplementation>(dc, delimiter, maxrowsize)) {}
 
 CDSVReader::~CDSVReader() = default;
 
@@ -80,4 +241,20 @@ bool CDSVReader::End() const {
 
 bool CDSVReader::ReadRow(std::vector<std::string>& row) {
     return DImplementation->ReadRow(row);
-}
\ No newline at end of file
+}
+
+bool CDSVReader::ReadRowView(std::vector<std::string_view>& row) {
+    return DImplementation->ReadRowView(row);
+}
+
+bool CDSVReader::ReadBatch(std::size_t maxRows, CColumnBatch& batch) {
+    return DImplementation->ReadBatch(maxRows, batch);
+}
+
+void CDSVReader::SetSchema(const std::vector<EColumnType>& schema) {
+    DImplementation->SetSchema(schema);
+}
+
+bool CDSVReader::ReadTypedRow(std::vector<STypedField>& row) {
+    return DImplementation->ReadTypedRow(row);
+}
@@ -0,0 +1,255 @@
+#include "DSVScanner.h"
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DSVSCANNER_X86
+#endif
+
+namespace DSVScanner{
+
+namespace{
+
+using TClassifyFunction = SBlockMasks (*)(const char *block, char delimiter);
+
+SBlockMasks ClassifyScalar(const char *block, char delimiter){
+    SBlockMasks Masks = {0, 0, 0};
+    for(std::size_t Index = 0; Index < BlockSize; Index++){
+        uint64_t Bit = uint64_t(1) << Index;
+        char Ch = block[Index];
+        Masks.DQuote |= Ch == '"' ? Bit : 0;
+        Masks.DDelimiter |= Ch == delimiter ? Bit : 0;
+        Masks.DNewline |= Ch == '\n' ? Bit : 0;
+    }
+    return Masks;
+}
+
+#if defined(DSVSCANNER_X86)
+__attribute__((target("sse2")))
+uint64_t MatchSSE2(const __m128i (&chunks)[4], char ch){
+    __m128i Value = _mm_set1_epi8(ch);
+    uint64_t Mask = 0;
+    for(int Index = 0; Index < 4; Index++){
+        Mask |= uint64_t(uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[Index], Value)))) << (Index * 16);
+    }
+    return Mask;
+}
+
+__attribute__((target("sse2")))
+SBlockMasks ClassifySSE2(const char *block, char delimiter){
+    __m128i Chunks[4];
+    for(int Index = 0; Index < 4; Index++){
+        Chunks[Index] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + Index * 16));
+    }
+    return {MatchSSE2(Chunks, '"'), MatchSSE2(Chunks, delimiter), MatchSSE2(Chunks, '\n')};
+}
+
+__attribute__((target("avx2")))
+uint64_t MatchAVX2(__m256i low, __m256i high, char ch){
+    __m256i Value = _mm256_set1_epi8(ch);
+    uint64_t Low = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, Value)));
+    uint64_t High = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, Value)));
+    return Low | (High << 32);
+}
+
+__attribute__((target("avx2")))
+SBlockMasks ClassifyAVX2(const char *block, char delimiter){
+    __m256i Low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    __m256i High = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+    return {MatchAVX2(Low, High, '"'), MatchAVX2(Low, High, delimiter), MatchAVX2(Low, High, '\n')};
+}
+#endif
+
+bool Supported(EImplementation implementation){
+    switch(implementation){
+#if defined(DSVSCANNER_X86)
+        case EImplementation::AVX2:     return __builtin_cpu_supports("avx2");
+        case EImplementation::SSE2:     return __builtin_cpu_supports("sse2");
+#endif
+        case EImplementation::Scalar:   return true;
+        default:                        return false;
+    }
+}
+
+TClassifyFunction FunctionFor(EImplementation implementation){
+    switch(implementation){
+#if defined(DSVSCANNER_X86)
+        case EImplementation::AVX2:     return ClassifyAVX2;
+        case EImplementation::SSE2:     return ClassifySSE2;
+#endif
+        default:                        return ClassifyScalar;
+    }
+}
+
+EImplementation BestImplementation(){
+#if defined(DSVSCANNER_X86)
+    // May run before the constructor that normally initializes the CPU data
+    __builtin_cpu_init();
+#endif
+    for(auto Implementation : {EImplementation::AVX2, EImplementation::SSE2}){
+        if(Supported(Implementation)){
+            return Implementation;
+        }
+    }
+    return EImplementation::Scalar;
+}
+
+EImplementation CurrentImplementation = BestImplementation();
+TClassifyFunction CurrentClassify = FunctionFor(CurrentImplementation);
+
+// Classifies the block at data + offset, padding a short final block
+inline SBlockMasks ClassifyAt(const char *data, std::size_t offset, std::size_t length, char delimiter){
+    std::size_t Remaining = length - offset;
+    if(Remaining >= BlockSize){
+        return CurrentClassify(data + offset, delimiter);
+    }
+    char Block[BlockSize] = {0};
+    std::memcpy(Block, data + offset, Remaining);
+    SBlockMasks Masks = CurrentClassify(Block, delimiter);
+    uint64_t Valid = (uint64_t(1) << Remaining) - 1;
+    Masks.DQuote &= Valid;
+    Masks.DDelimiter &= Valid;
+    Masks.DNewline &= Valid;
+    return Masks;
+}
+
+// Mask of the bits of the block at offset that are at or after position
+inline uint64_t BitsFrom(std::size_t position, std::size_t offset){
+    if(position <= offset){
+        return ~uint64_t(0);
+    }
+    return position - offset >= BlockSize ? 0 : ~uint64_t(0) << (position - offset);
+}
+
+// Walks the structural characters from start and returns the first row end
+// at or after minimum, or length if there is none. Rows that end before
+// minimum are passed over, the delimiters are only collected when rows are
+// not skipped.
+template <bool CollectDelimiters> std::size_t ScanRows(const char *data, std::size_t start, std::size_t minimum, std::size_t length, char delimiter, SScanState &state, std::vector< std::size_t > *delimiters){
+    std::size_t Position = start;
+    if(state.DQuotePending){
+        if(Position == length){
+            return length;
+        }
+        // A quote inside a quoted field followed by another is an escaped
+        // quote, followed by anything else it closes the field
+        state.DQuotePending = false;
+        if(data[Position] == '"'){
+            Position++;
+        }
+        else{
+            state.DInQuotes = false;
+        }
+    }
+    for(std::size_t Offset = Position; Offset < length; Offset += BlockSize){
+        SBlockMasks Masks = ClassifyAt(data, Offset, length, delimiter);
+        // Bits before Position have already been handled
+        uint64_t Remaining = BitsFrom(Position, Offset);
+        if(!state.DInQuotes && !(Masks.DQuote & Remaining)){
+            // Without quotes every delimiter and newline is structural
+            uint64_t Newlines = Masks.DNewline & Remaining;
+            uint64_t Ends = Newlines & BitsFrom(minimum, Offset);
+            uint64_t Delimiters = Masks.DDelimiter & Remaining;
+            if(Ends){
+                // Only keep the delimiters before the row end
+                Delimiters &= (Ends & -Ends) - 1;
+            }
+            if(CollectDelimiters){
+                while(Delimiters){
+                    delimiters->push_back(Offset + __builtin_ctzll(Delimiters));
+                    Delimiters &= Delimiters - 1;
+                }
+            }
+            if(Ends){
+                std::size_t RowEnd = Offset + __builtin_ctzll(Ends);
+                state.DFieldStart = state.DRowStart = RowEnd + 1;
+                return RowEnd;
+            }
+            if(Newlines){
+                state.DRowStart = Offset + BlockSize - __builtin_clzll(Newlines);
+            }
+            uint64_t Structural = (Masks.DDelimiter | Masks.DNewline) & Remaining;
+            if(Structural){
+                state.DFieldStart = Offset + BlockSize - __builtin_clzll(Structural);
+            }
+            continue;
+        }
+        // Walk the structural characters in order. Inside a quoted field only
+        // quotes matter, and newlines once the row is over the size limit.
+        while(true){
+            uint64_t Candidates = Masks.DQuote | Masks.DDelimiter | Masks.DNewline;
+            if(state.DInQuotes){
+                std::size_t Limit = state.DMaxRowSize > SIZE_MAX - state.DRowStart ? SIZE_MAX : state.DRowStart + state.DMaxRowSize;
+                Candidates = Masks.DQuote | (Masks.DNewline & BitsFrom(Limit, Offset));
+            }
+            Candidates &= Remaining;
+            if(!Candidates){
+                break;
+            }
+            unsigned Bit = __builtin_ctzll(Candidates);
+            std::size_t At = Offset + Bit;
+            Remaining &= ~((uint64_t(2) << Bit) - 1);
+            if(data[At] == '"'){
+                if(!state.DInQuotes){
+                    // A quote opens a quoted field only as its first
+                    // character, anywhere else it is an ordinary character
+                    state.DInQuotes = At == state.DFieldStart;
+                }
+                else if(At + 1 == length){
+                    state.DQuotePending = true;
+                    return length;
+                }
+                else if(data[At + 1] == '"'){
+                    Position = At + 2;
+                    Remaining &= ~(uint64_t(2) << Bit);
+                }
+                else{
+                    state.DInQuotes = false;
+                }
+            }
+            else if(data[At] == '\n'){
+                state.DInQuotes = false;
+                state.DFieldStart = state.DRowStart = At + 1;
+                if(At >= minimum){
+                    return At;
+                }
+            }
+            else{
+                if(CollectDelimiters){
+                    delimiters->push_back(At);
+                }
+                state.DFieldStart = At + 1;
+            }
+        }
+    }
+    return length;
+}
+
+}
+
+SBlockMasks Classify(const char *data, std::size_t length, char delimiter) noexcept{
+    return ClassifyAt(data, 0, length < BlockSize ? length : BlockSize, delimiter);
+}
+
+std::size_t FindRowEnd(const char *data, std::size_t start, std::size_t length, char delimiter, SScanState &state, std::vector< std::size_t > &delimiters) noexcept{
+    return ScanRows<true>(data, start, start, length, delimiter, state, &delimiters);
+}
+
+std::size_t FindRowEndAfter(const char *data, std::size_t start, std::size_t minimum, std::size_t length, char delimiter, SScanState &state) noexcept{
+    return ScanRows<false>(data, start, minimum, length, delimiter, state, nullptr);
+}
+
+EImplementation ActiveImplementation() noexcept{
+    return CurrentImplementation;
+}
+
+bool SelectImplementation(EImplementation implementation) noexcept{
+    if(!Supported(implementation)){
+        return false;
+    }
+    CurrentImplementation = implementation;
+    CurrentClassify = FunctionFor(implementation);
+    return true;
+}
+
+}
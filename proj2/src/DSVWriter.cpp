@@ -3,62 +3,78 @@
 #include "StringDataSink.h"
 #include <vector>
 #include <string>
-#include <sstream>
 
 struct CDSVWriter::SImplementation {
     std::shared_ptr<CDataSink> Sink;
     char Delimiter;
     bool QuoteAll;
+    std::size_t FlushThreshold;
+    // Rows not yet written to the sink, reused so rows do not allocate
+    std::string Buffer;
+    // Characters that force a field to be quoted
+    char SpecialChars[4];
 
-    SImplementation(std::shared_ptr<CDataSink> sink, char delimiter, bool quoteall) 
-        : Sink(sink), Delimiter(delimiter), QuoteAll(quoteall) {}
+    SImplementation(std::shared_ptr<CDataSink> sink, char delimiter, bool quoteall, std::size_t flushthreshold) 
+        : Sink(sink), Delimiter(delimiter), QuoteAll(quoteall), FlushThreshold(flushthreshold), SpecialChars{delimiter, '\"', '\n', '\0'} {
+        Buffer.reserve(flushthreshold + 1024);
+    }
 
     SImplementation()
-        : Sink(nullptr), Delimiter(','), QuoteAll(false) {}
+        : SImplementation(nullptr, ',', false, 0) {}
+
+    // Appends a field to the buffer, quoting it and doubling any quotes if needed
+    void AppendField(const std::string& fieldValue) {
+        if (!QuoteAll && fieldValue.find_first_of(SpecialChars, 0, 3) == std::string::npos) {
+            Buffer += fieldValue;
+            return;
+        }
+        Buffer += '\"';
+        std::size_t start = 0;
+        std::size_t quote;
+        while ((quote = fieldValue.find('\"', start)) != std::string::npos) {
+            Buffer.append(fieldValue, start, quote + 1 - start);
+            Buffer += '\"'; // Escaped quote
+            start = quote + 1;
+        }
+        Buffer.append(fieldValue, start, std::string::npos);
+        Buffer += '\"';
+    }
+
+    bool Flush() {
+        if (Buffer.empty()) {
+            return true;
+        }
+        bool result = Sink->WriteBlock(Buffer.data(), Buffer.size());
+        Buffer.clear();
+        return result;
+    }
 };
-CDSVWriter::CDSVWriter(std::shared_ptr<CDataSink> sink, char delimiter, bool quoteall)
-    : DImplementation(std::make_unique<SImplementation>(sink, delimiter, quoteall)) {
+
+CDSVWriter::CDSVWriter(std::shared_ptr<CDataSink> sink, char delimiter, bool quoteall, std::size_t flushthreshold)
+    : DImplementation(std::make_unique<SImplementation>(sink, delimiter, quoteall, flushthreshold)) {
 }
 
 CDSVWriter::~CDSVWriter() { // destructor
+    DImplementation->Flush();
 }
 
 bool CDSVWriter::WriteRow(const std::vector<std::string>& dataRow) {
-    std::vector<std::string> formattedFields;
-    formattedFields.reserve(dataRow.size());
-
-    for (const auto& fieldValue : dataRow) {
-        bool requiresQuoting = DImplementation->QuoteAll || 
-                               fieldValue.find(DImplementation->Delimiter) != std::string::npos || 
-                               fieldValue.find('\"') != std::string::npos || 
-                               fieldValue.find('\n') != std::string::npos;
-
-        if (requiresQuoting) {
-            std::ostringstream quotedField;
-            quotedField << '\"';
-            for (char character : fieldValue) {
-                if (character == '\"') {
-                    quotedField << "\"\""; 
-                } else {
-                    quotedField << character;
-                }
-            }
-            quotedField << '\"';
-            formattedFields.push_back(quotedField.str());
-        } else {
-            formattedFields.push_back(fieldValue);
-        }
-    }
-
-    std::string formattedRow;
-    for (size_t i = 0; i < formattedFields.size(); ++i) {
+    for (size_t i = 0; i < dataRow.size(); ++i) {
         if (i > 0) {
-            formattedRow += DImplementation->Delimiter; // Add delimiter between fields
+            DImplementation->Buffer += DImplementation->Delimiter; // Add delimiter between fields
         }
-        formattedRow += formattedFields[i];
+        DImplementation->AppendField(dataRow[i]);
     }
 
-    formattedRow += '\n'; // Append newline at the end
+    DImplementation->Buffer += '\n'; // Append newline at the end
+
+    if (DImplementation->Buffer.size() >= DImplementation->FlushThreshold) {
+        return DImplementation->Flush(); // Write to sink
+    }
+    return true;
+}
 
-    return DImplementation->Sink->Write(std::vector<char>(formattedRow.begin(), formattedRow.end())); // Write to sink
+bool CDSVWriter::Flush() {
+    bool result = DImplementation->Flush();
+    return DImplementation->Sink->Flush() && result;
 }
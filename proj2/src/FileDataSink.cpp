@@ -0,0 +1,196 @@
+#include "FileDataSink.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+struct CFileDataSink::SImplementation{
+    // O_DIRECT needs the buffer address, length and file offset aligned to
+    // the logical block size, a page covers every common device
+    static constexpr std::size_t DAlignment = 4096;
+
+    int DFileDescriptor;
+    bool DOwned;
+    bool DDirect;
+    ESyncPolicy DSync;
+    char *DBuffer = nullptr;
+    std::size_t DBufferSize;
+    std::size_t DBufferLength = 0;
+    uint64_t DBytesWritten = 0;
+    bool DError = false;
+
+    SImplementation(int fd, bool owned, bool direct, ESyncPolicy sync, std::size_t buffersize)
+        : DFileDescriptor(fd), DOwned(owned), DDirect(direct), DSync(sync){
+        DBufferSize = std::max(DAlignment, (buffersize + DAlignment - 1) / DAlignment * DAlignment);
+        void *Buffer = nullptr;
+        if(posix_memalign(&Buffer, DAlignment, DBufferSize) == 0){
+            DBuffer = static_cast<char *>(Buffer);
+        }
+        DError = (DFileDescriptor < 0) || !DBuffer;
+    }
+
+    ~SImplementation(){
+        Flush(DSync != ESyncPolicy::None);
+        if(DOwned && (DFileDescriptor >= 0)){
+            close(DFileDescriptor);
+        }
+        free(DBuffer);
+    }
+
+    static int Open(const std::string &filename, bool &direct){
+        int Flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+#ifdef O_DIRECT
+        if(direct){
+            int FileDescriptor = open(filename.c_str(), Flags | O_DIRECT, 0666);
+            // Some file systems such as tmpfs refuse O_DIRECT
+            if((FileDescriptor >= 0) || (errno != EINVAL)){
+                return FileDescriptor;
+            }
+        }
+#endif
+        direct = false;
+        return open(filename.c_str(), Flags, 0666);
+    }
+
+    // Writes all of the vectors, retrying after partial writes
+    bool WriteVectors(struct iovec *vectors, int count){
+        while(count && !DError){
+            ssize_t Result = writev(DFileDescriptor, vectors, count);
+            if(Result < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                DError = true;
+                break;
+            }
+            DBytesWritten += Result;
+            std::size_t Remaining = Result;
+            while(count && (Remaining >= vectors->iov_len)){
+                Remaining -= vectors->iov_len;
+                vectors++;
+                count--;
+            }
+            if(count){
+                vectors->iov_base = static_cast<char *>(vectors->iov_base) + Remaining;
+                vectors->iov_len -= Remaining;
+            }
+        }
+        return !DError;
+    }
+
+    void DisableDirect(){
+#ifdef O_DIRECT
+        if(DDirect){
+            fcntl(DFileDescriptor, F_SETFL, fcntl(DFileDescriptor, F_GETFL) & ~O_DIRECT);
+            DDirect = false;
+        }
+#endif
+    }
+
+    // Writes the buffer followed by an optional block of the caller's
+    bool WriteBuffer(const char *block = nullptr, std::size_t count = 0){
+        struct iovec Vectors[2];
+        int VectorCount = 0;
+        if(DBufferLength){
+            Vectors[VectorCount++] = {DBuffer, DBufferLength};
+        }
+        if(count){
+            Vectors[VectorCount++] = {const_cast<char *>(block), count};
+        }
+        if(DDirect && (DBufferLength % DAlignment)){
+            // The partial block at the end can only be written buffered, the
+            // file offset is unaligned from then on
+            DisableDirect();
+        }
+        bool Result = WriteVectors(Vectors, VectorCount);
+        DBufferLength = 0;
+        return Result;
+    }
+
+    bool WriteBlock(const char *buf, std::size_t count){
+        if(DError){
+            return false;
+        }
+        if(!DDirect && (DBufferLength + count > DBufferSize) && (count >= DBufferSize)){
+            return WriteBuffer(buf, count);
+        }
+        while(count){
+            std::size_t Length = std::min(count, DBufferSize - DBufferLength);
+            std::memcpy(DBuffer + DBufferLength, buf, Length);
+            DBufferLength += Length;
+            buf += Length;
+            count -= Length;
+            if((DBufferLength == DBufferSize) && !WriteBuffer()){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Flush(bool sync){
+        if(DError){
+            return false;
+        }
+        if(!WriteBuffer()){
+            return false;
+        }
+        if(sync && (fdatasync(DFileDescriptor) != 0) && (errno != EINVAL)){
+            DError = true;
+        }
+        return !DError;
+    }
+};
+
+CFileDataSink::CFileDataSink(const std::string &filename, bool directio, ESyncPolicy sync, std::size_t buffersize){
+    bool Direct = directio;
+    int FileDescriptor = SImplementation::Open(filename, Direct);
+    DImplementation = std::make_unique<SImplementation>(FileDescriptor, true, Direct, sync, buffersize);
+}
+
+CFileDataSink::CFileDataSink(int fd, ESyncPolicy sync, std::size_t buffersize)
+    : DImplementation(std::make_unique<SImplementation>(fd, false, false, sync, buffersize)){
+
+}
+
+CFileDataSink::~CFileDataSink(){
+
+}
+
+bool CFileDataSink::IsOpen() const noexcept{
+    return DImplementation->DFileDescriptor >= 0;
+}
+
+bool CFileDataSink::IsDirect() const noexcept{
+    return DImplementation->DDirect;
+}
+
+uint64_t CFileDataSink::BytesWritten() const noexcept{
+    return DImplementation->DBytesWritten;
+}
+
+bool CFileDataSink::Put(const char &ch) noexcept{
+    auto &Implementation = *DImplementation;
+    if(Implementation.DError){
+        return false;
+    }
+    Implementation.DBuffer[Implementation.DBufferLength++] = ch;
+    if(Implementation.DBufferLength == Implementation.DBufferSize){
+        return Implementation.WriteBuffer();
+    }
+    return true;
+}
+
+bool CFileDataSink::Write(const std::vector<char> &buf) noexcept{
+    return DImplementation->WriteBlock(buf.data(), buf.size());
+}
+
+bool CFileDataSink::WriteBlock(const char *buf, std::size_t count) noexcept{
+    return DImplementation->WriteBlock(buf, count);
+}
+
+bool CFileDataSink::Flush() noexcept{
+    return DImplementation->Flush(DImplementation->DSync == ESyncPolicy::OnFlush);
+}
@@ -0,0 +1,170 @@
+#include "FileDataSource.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct CFileDataSource::SImplementation{
+    static constexpr std::size_t DStreamBufferSize = 65536;
+    // Pages already consumed are handed back to the kernel every interval so
+    // resident memory stays flat no matter how large the file is
+    static constexpr std::size_t DReleaseInterval = 64 * 1024 * 1024;
+
+    int DFileDescriptor;
+    bool DOwned;
+    const char *DMapped = nullptr;
+    std::size_t DMappedSize = 0;
+    const char *DReleased = nullptr;
+    const char *DNextRelease = nullptr;
+    std::vector<char> DBuffer;
+    const char *DCurrent = nullptr;
+    const char *DLimit = nullptr;
+    bool DEndOfFile = false;
+
+    SImplementation(int fd, bool owned) : DFileDescriptor(fd), DOwned(owned){
+        if(DFileDescriptor < 0){
+            DEndOfFile = true;
+            return;
+        }
+        struct stat FileStat;
+        if((fstat(DFileDescriptor, &FileStat) == 0) && S_ISREG(FileStat.st_mode) && (FileStat.st_size > 0)){
+            off_t Offset = lseek(DFileDescriptor, 0, SEEK_CUR);
+            if(Offset < 0){
+                Offset = 0;
+            }
+            std::size_t Size = FileStat.st_size;
+            void *Mapping = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, DFileDescriptor, 0);
+            if(Mapping != MAP_FAILED){
+                madvise(Mapping, Size, MADV_SEQUENTIAL);
+                DMapped = static_cast<const char *>(Mapping);
+                DMappedSize = Size;
+                DReleased = DMapped;
+                DCurrent = DMapped + std::min<std::size_t>(Offset, Size);
+                DLimit = DMapped + Size;
+                DNextRelease = DReleased + DReleaseInterval;
+                DEndOfFile = true;
+                return;
+            }
+        }
+        DBuffer.resize(DStreamBufferSize);
+    }
+
+    ~SImplementation(){
+        if(DMapped){
+            munmap(const_cast<char *>(DMapped), DMappedSize);
+        }
+        if(DOwned && (DFileDescriptor >= 0)){
+            close(DFileDescriptor);
+        }
+    }
+
+    void Release(){
+        std::size_t Length = DCurrent - DReleased;
+        Length -= Length % DReleaseInterval;
+        if(Length){
+            madvise(const_cast<char *>(DReleased), Length, MADV_DONTNEED);
+            DReleased += Length;
+        }
+        DNextRelease = DReleased + DReleaseInterval;
+    }
+
+    // Makes sure at least one byte is available, returns false at end of file
+    bool Fill(){
+        if(DCurrent < DLimit){
+            return true;
+        }
+        while(!DEndOfFile){
+            ssize_t Result = read(DFileDescriptor, DBuffer.data(), DBuffer.size());
+            if(Result > 0){
+                DCurrent = DBuffer.data();
+                DLimit = DCurrent + Result;
+                return true;
+            }
+            if((Result < 0) && (errno == EINTR)){
+                continue;
+            }
+            DEndOfFile = true;
+        }
+        return false;
+    }
+
+    bool Get(char &ch){
+        if(!Fill()){
+            return false;
+        }
+        ch = *DCurrent++;
+        if(DCurrent >= DNextRelease && DMapped){
+            Release();
+        }
+        return true;
+    }
+
+    bool Peek(char &ch){
+        if(!Fill()){
+            return false;
+        }
+        ch = *DCurrent;
+        return true;
+    }
+
+    std::size_t ReadBlock(char *buf, std::size_t count){
+        std::size_t Total = 0;
+        while((Total < count) && Fill()){
+            std::size_t Length = std::min<std::size_t>(count - Total, DLimit - DCurrent);
+            std::memcpy(buf + Total, DCurrent, Length);
+            DCurrent += Length;
+            Total += Length;
+        }
+        if(DMapped && (DCurrent >= DNextRelease)){
+            Release();
+        }
+        return Total;
+    }
+};
+
+CFileDataSource::CFileDataSource(const std::string &filename)
+    : DImplementation(std::make_unique<SImplementation>(open(filename.c_str(), O_RDONLY | O_CLOEXEC), true)){
+
+}
+
+CFileDataSource::CFileDataSource(int fd)
+    : DImplementation(std::make_unique<SImplementation>(fd, false)){
+
+}
+
+CFileDataSource::~CFileDataSource(){
+
+}
+
+bool CFileDataSource::IsOpen() const noexcept{
+    return DImplementation->DFileDescriptor >= 0;
+}
+
+bool CFileDataSource::IsMapped() const noexcept{
+    return DImplementation->DMapped != nullptr;
+}
+
+bool CFileDataSource::End() const noexcept{
+    return !DImplementation->Fill();
+}
+
+bool CFileDataSource::Get(char &ch) noexcept{
+    return DImplementation->Get(ch);
+}
+
+bool CFileDataSource::Peek(char &ch) noexcept{
+    return DImplementation->Peek(ch);
+}
+
+bool CFileDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    buf.resize(count);
+    buf.resize(DImplementation->ReadBlock(buf.data(), count));
+    return !buf.empty();
+}
+
+std::size_t CFileDataSource::ReadBlock(char *buf, std::size_t count) noexcept{
+    return DImplementation->ReadBlock(buf, count);
+}
@@ -0,0 +1,189 @@
+#include "ParallelDSVReader.h"
+#include "DSVReader.h"
+#include "DSVScanner.h"
+#include "ParallelUtils.h"
+#include "StringViewDataSource.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+struct CParallelDSVReader::SImplementation{
+    using TRows = std::vector< std::vector< std::string > >;
+    static constexpr std::size_t InitialBufferSize = 65536;
+
+    std::shared_ptr< CDataSource > DSource;
+    char DDelimiter;
+    std::size_t DThreads;
+    std::size_t DMaxRowSize;
+    // Size the buffer grows to while the input lasts, a block for all threads
+    std::size_t DBlockSize;
+    // Input not yet handed to the workers lives in DBuffer[0, DBufferLength),
+    // it always begins at the start of a row
+    std::vector< char > DBuffer;
+    std::size_t DBufferLength = 0;
+    bool DSourceEnd = false;
+    std::size_t DNextChunkIndex = 0;
+    // Parsed rows of the current block waiting to be returned by ReadRow
+    std::vector< TRows > DChunkRows;
+    std::size_t DChunk = 0;
+    std::size_t DRow = 0;
+
+    SImplementation(std::shared_ptr< CDataSource > src, char delimiter, std::size_t threads, std::size_t chunksize, std::size_t maxrowsize)
+        : DSource(src), DDelimiter(delimiter == '"' ? ',' : delimiter), DMaxRowSize(maxrowsize){
+        DThreads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        DBlockSize = DThreads * std::max<std::size_t>(chunksize, 1);
+        // The buffer only grows as far as the input needs it to
+        DBuffer.resize(std::min(DBlockSize, InitialBufferSize));
+    }
+
+    // Fills the buffer and splits it into one chunk of complete rows per
+    // thread, the chunk bounds go into bounds and the length of the complete
+    // rows is returned. The buffer is grown until it holds a complete row.
+    std::size_t FillBlock(std::vector< std::size_t > &bounds){
+        while(true){
+            while(!DSourceEnd && (DBufferLength < DBuffer.size())){
+                std::size_t Length = DSource->ReadBlock(DBuffer.data() + DBufferLength, DBuffer.size() - DBufferLength);
+                if(!Length){
+                    DSourceEnd = true;
+                }
+                DBufferLength += Length;
+                if((DBufferLength == DBuffer.size()) && (DBuffer.size() < DBlockSize)){
+                    DBuffer.resize(std::min(DBuffer.size() * 2, DBlockSize));
+                }
+            }
+            // Row ends depend on all of the quotes before them, so the bounds
+            // are found in one vectorized pass over the block. Each chunk
+            // ends at the first row end past its share of the block.
+            DSVScanner::SScanState State;
+            State.DMaxRowSize = DMaxRowSize;
+            std::size_t Position = 0;
+            bounds.assign(DThreads + 1, 0);
+            for(std::size_t Index = 1; Index < DThreads; Index++){
+                std::size_t Target = DBufferLength * Index / DThreads;
+                if(Target >= Position){
+                    std::size_t RowEnd = DSVScanner::FindRowEndAfter(DBuffer.data(), Position, Target, DBufferLength, DDelimiter, State);
+                    Position = std::min(RowEnd + 1, DBufferLength);
+                }
+                bounds[Index] = Position;
+            }
+            std::size_t Cut = DBufferLength;
+            if(!DSourceEnd){
+                // The last row is most likely incomplete
+                DSVScanner::FindRowEndAfter(DBuffer.data(), Position, DBufferLength, DBufferLength, DDelimiter, State);
+                Cut = State.DRowStart;
+            }
+            if(Cut || DSourceEnd){
+                for(auto &Bound : bounds){
+                    Bound = std::min(Bound, Cut);
+                }
+                bounds[DThreads] = Cut;
+                return Cut;
+            }
+            DBuffer.resize(DBuffer.size() * 2);
+        }
+    }
+
+    // Parses the next block, either storing the rows for ReadRow or passing
+    // them to callback. Returns false once the input is exhausted.
+    bool ParseBlock(const TChunkCallback *callback){
+        std::vector< std::size_t > Bounds;
+        std::size_t Cut = FillBlock(Bounds);
+        if(!Cut){
+            return false;
+        }
+        std::size_t FirstChunkIndex = DNextChunkIndex;
+        DNextChunkIndex += DThreads;
+        DChunkRows.resize(DThreads);
+        ParallelUtils::RunParallel(DThreads, [&](std::size_t index){
+            TRows &Rows = DChunkRows[index];
+            Rows.clear();
+            if(Bounds[index] < Bounds[index + 1]){
+                auto Source = std::make_shared< CStringViewDataSource >(DBuffer.data() + Bounds[index], Bounds[index + 1] - Bounds[index]);
+                CDSVReader Reader(Source, DDelimiter, DMaxRowSize);
+                std::vector< std::string > Row;
+                // Empty lines are kept as empty rows, as CDSVReader reports
+                while(!Reader.End()){
+                    Reader.ReadRow(Row);
+                    Rows.push_back(Row);
+                }
+            }
+            if(callback){
+                (*callback)(FirstChunkIndex + index, Rows);
+            }
+        });
+
+        // Carry the incomplete last row over to the next block
+        std::memmove(DBuffer.data(), DBuffer.data() + Cut, DBufferLength - Cut);
+        DBufferLength -= Cut;
+        DChunk = 0;
+        DRow = 0;
+        if(callback){
+            DChunkRows.clear();
+        }
+        return true;
+    }
+
+    bool End(){
+        while(true){
+            while((DChunk < DChunkRows.size()) && (DRow >= DChunkRows[DChunk].size())){
+                DChunk++;
+                DRow = 0;
+            }
+            if(DChunk < DChunkRows.size()){
+                return false;
+            }
+            if(!ParseBlock(nullptr)){
+                return true;
+            }
+        }
+    }
+
+    bool ReadRow(std::vector< std::string > &row){
+        if(End()){
+            row.clear();
+            return false;
+        }
+        std::swap(row, DChunkRows[DChunk][DRow++]);
+        return !row.empty();
+    }
+
+    bool ReadChunks(const TChunkCallback &callback){
+        bool Result = false;
+        // Hand over whatever ReadRow has not returned yet as its own chunk
+        TRows Pending;
+        for(; DChunk < DChunkRows.size(); DChunk++, DRow = 0){
+            auto &Rows = DChunkRows[DChunk];
+            std::move(Rows.begin() + std::min(DRow, Rows.size()), Rows.end(), std::back_inserter(Pending));
+        }
+        DChunkRows.clear();
+        if(!Pending.empty()){
+            callback(DNextChunkIndex++, Pending);
+            Result = true;
+        }
+        while(ParseBlock(&callback)){
+            Result = true;
+        }
+        return Result;
+    }
+};
+
+CParallelDSVReader::CParallelDSVReader(std::shared_ptr< CDataSource > src, char delimiter, std::size_t threads, std::size_t chunksize, std::size_t maxrowsize)
+    : DImplementation(std::make_unique<SImplementation>(src, delimiter, threads, chunksize, maxrowsize)){
+
+}
+
+CParallelDSVReader::~CParallelDSVReader(){
+
+}
+
+bool CParallelDSVReader::End() const{
+    return DImplementation->End();
+}
+
+bool CParallelDSVReader::ReadRow(std::vector<std::string> &row){
+    return DImplementation->ReadRow(row);
+}
+
+bool CParallelDSVReader::ReadChunks(const TChunkCallback &callback){
+    return DImplementation->ReadChunks(callback);
+}
@@ -0,0 +1,419 @@
+#include "ParallelXMLReader.h"
+#include "XMLReader.h"
+#include "ParallelUtils.h"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <thread>
+
+namespace{
+
+// Source over the document prolog, one chunk of records and the root end
+// tag, so the chunk parses as a document of its own without being copied.
+// The rest of the document can follow from another source.
+class CWrappedChunkDataSource : public CDataSource{
+    private:
+        std::string_view DPieces[3];
+        std::size_t DPiece;
+        std::size_t DIndex;
+        std::shared_ptr< CDataSource > DRest;
+
+        void SkipEmpty(){
+            while((DPiece < 3) && (DIndex >= DPieces[DPiece].size())){
+                DPiece++;
+                DIndex = 0;
+            }
+        }
+
+    public:
+        CWrappedChunkDataSource(std::string_view prefix, std::string_view chunk, std::string_view suffix, std::shared_ptr< CDataSource > rest = nullptr) : DPieces{prefix, chunk, suffix}, DPiece(0), DIndex(0), DRest(rest){
+            SkipEmpty();
+        }
+
+        bool End() const noexcept override{
+            return (DPiece >= 3) && (!DRest || DRest->End());
+        }
+
+        bool Get(char &ch) noexcept override{
+            if(DPiece >= 3){
+                return DRest && DRest->Get(ch);
+            }
+            ch = DPieces[DPiece][DIndex++];
+            SkipEmpty();
+            return true;
+        }
+
+        bool Peek(char &ch) noexcept override{
+            if(DPiece >= 3){
+                return DRest && DRest->Peek(ch);
+            }
+            ch = DPieces[DPiece][DIndex];
+            return true;
+        }
+
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override{
+            buf.resize(count);
+            buf.resize(ReadBlock(buf.data(), count));
+            return !buf.empty();
+        }
+
+        std::size_t ReadBlock(char *buf, std::size_t count) noexcept override{
+            std::size_t Length = 0;
+            while((Length < count) && (DPiece < 3)){
+                std::size_t Copy = std::min(count - Length, DPieces[DPiece].size() - DIndex);
+                std::memcpy(buf + Length, DPieces[DPiece].data() + DIndex, Copy);
+                Length += Copy;
+                DIndex += Copy;
+                SkipEmpty();
+            }
+            if((Length < count) && DRest){
+                Length += DRest->ReadBlock(buf + Length, count - Length);
+            }
+            return Length;
+        }
+};
+
+// Collects the entities of the records in one parsed chunk
+class CRecordHandler : public CXMLHandler{
+    private:
+        const std::string &DRecordName;
+        std::vector< std::vector< SXMLEntity > > &DRecords;
+        std::size_t DDepth = 0;
+        bool DInRecord = false;
+        std::size_t DComplete = 0;
+
+        void PushEntity(SXMLEntity::EType type, std::string_view name){
+            DRecords.back().emplace_back();
+            DRecords.back().back().DType = type;
+            DRecords.back().back().DNameData.assign(name.data(), name.size());
+        }
+
+    public:
+        CRecordHandler(const std::string &recordname, std::vector< std::vector< SXMLEntity > > &records) : DRecordName(recordname), DRecords(records){
+
+        }
+
+        // Number of records that have seen their end element, after a parse
+        // error only these are kept
+        std::size_t Complete() const{
+            return DComplete;
+        }
+
+        void OnStart(std::string_view name, const std::vector< SXMLAttributeView > &attributes) override{
+            // The root is at depth one, records are its children
+            if((++DDepth == 2) && (DRecordName.empty() || (name == DRecordName))){
+                DInRecord = true;
+                DRecords.emplace_back();
+            }
+            if(DInRecord){
+                PushEntity(SXMLEntity::EType::StartElement, name);
+                for(auto &Attribute : attributes){
+                    DRecords.back().back().DAttributes.emplace_back(Attribute.DName, Attribute.DValue);
+                }
+            }
+        }
+
+        void OnEnd(std::string_view name) override{
+            if(DInRecord){
+                PushEntity(SXMLEntity::EType::EndElement, name);
+                DInRecord = DDepth > 2;
+                DComplete += !DInRecord;
+            }
+            DDepth--;
+        }
+
+        void OnCharData(std::string_view data) override{
+            if(DInRecord){
+                auto &Record = DRecords.back();
+                if(Record.back().DType == SXMLEntity::EType::CharData){
+                    Record.back().DNameData.append(data.data(), data.size());
+                }
+                else{
+                    PushEntity(SXMLEntity::EType::CharData, data);
+                }
+            }
+        }
+};
+
+}
+
+struct CParallelXMLReader::SImplementation{
+    using TRecords = std::vector< std::vector< SXMLEntity > >;
+    enum class EMarkup{StartTag, EndTag, EmptyTag, Other};
+    static constexpr std::size_t InitialBufferSize = 65536;
+
+    std::shared_ptr< CDataSource > DSource;
+    std::string DRecordName;
+    std::size_t DThreads;
+    std::size_t DChunkSize;
+    // Size the buffer grows to while the input lasts, a block for all threads
+    std::size_t DBlockSize;
+    // Input not yet parsed lives in DBuffer[0, DBufferLength), markup has
+    // been scanned up to DScanPosition
+    std::vector< char > DBuffer;
+    std::size_t DBufferLength = 0;
+    std::size_t DScanPosition = 0;
+    bool DSourceEnd = false;
+    // Element depth at DScanPosition, the root is at depth one
+    std::size_t DDepth = 0;
+    // Everything up to and including the root start tag, and the root end tag
+    std::string DPrefix;
+    std::string DSuffix;
+    bool DHaveRoot = false;
+    bool DDocumentEnd = false;
+    bool DTailParsed = false;
+    bool DError = false;
+    // Chunk boundaries of the current block, each between two records, and
+    // the last position found between two records
+    std::vector< std::size_t > DBounds = {0};
+    std::size_t DLastCut = 0;
+    // Parsed records of the current block waiting to be returned
+    std::vector< TRecords > DChunkRecords;
+    std::vector< char > DChunkSuccess;
+    std::size_t DChunk = 0;
+    std::size_t DRecord = 0;
+
+    SImplementation(std::shared_ptr< CDataSource > src, const std::string &recordname, std::size_t threads, std::size_t chunksize)
+        : DSource(src), DRecordName(recordname){
+        DThreads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        DChunkSize = std::max<std::size_t>(chunksize, 1);
+        DBlockSize = DThreads * DChunkSize;
+        // The buffer only grows as far as the input needs it to
+        DBuffer.resize(std::min(DBlockSize, InitialBufferSize));
+    }
+
+    // Returns the end of the markup starting with the '<' at position, or
+    // npos if it runs past the end of the data
+    static std::size_t MarkupEnd(std::string_view data, std::size_t position, EMarkup &markup){
+        auto After = [&](const char *terminator, std::size_t from){
+            std::size_t Found = data.find(terminator, from);
+            return Found == std::string_view::npos ? Found : Found + std::strlen(terminator);
+        };
+        if(position + 1 >= data.size()){
+            return std::string_view::npos;
+        }
+        markup = EMarkup::Other;
+        char Next = data[position + 1];
+        if(Next == '?'){
+            return After("?>", position + 2);
+        }
+        if(Next == '!'){
+            if(data.size() - position < 9){
+                return std::string_view::npos;
+            }
+            if(data.compare(position, 4, "<!--") == 0){
+                return After("-->", position + 4);
+            }
+            if(data.compare(position, 9, "<![CDATA[") == 0){
+                return After("]]>", position + 9);
+            }
+        }
+        else if(Next == '/'){
+            markup = EMarkup::EndTag;
+            return After(">", position + 2);
+        }
+        // A '>' may appear in quoted attribute values, and a DOCTYPE may hold
+        // an internal subset in brackets
+        char Quote = '\0';
+        std::size_t Brackets = 0;
+        for(std::size_t Index = position + 1; Index < data.size(); Index++){
+            char Ch = data[Index];
+            if(Quote){
+                Quote = Ch == Quote ? '\0' : Quote;
+            }
+            else if((Ch == '"') || (Ch == '\'')){
+                Quote = Ch;
+            }
+            else if(Ch == '['){
+                Brackets++;
+            }
+            else if((Ch == ']') && Brackets){
+                Brackets--;
+            }
+            else if((Ch == '>') && !Brackets){
+                if(Next != '!'){
+                    markup = data[Index - 1] == '/' ? EMarkup::EmptyTag : EMarkup::StartTag;
+                }
+                return Index + 1;
+            }
+        }
+        return std::string_view::npos;
+    }
+
+    // Tracks the element depth through the newly read data, noting the end
+    // of the root start tag and the positions between two records
+    void Scan(){
+        std::string_view Data(DBuffer.data(), DBufferLength);
+        while(!DDocumentEnd && (DScanPosition < Data.size())){
+            const char *Open = static_cast< const char * >(std::memchr(Data.data() + DScanPosition, '<', Data.size() - DScanPosition));
+            if(!Open){
+                DScanPosition = Data.size();
+                break;
+            }
+            std::size_t Position = Open - Data.data();
+            EMarkup Markup;
+            std::size_t End = MarkupEnd(Data, Position, Markup);
+            if(End == std::string_view::npos){
+                DScanPosition = Position;
+                break;
+            }
+            DScanPosition = End;
+            if(Markup == EMarkup::StartTag){
+                if(++DDepth == 1){
+                    std::size_t NameEnd = Data.find_first_of(" \t\r\n>", Position + 1);
+                    DPrefix.assign(Data.data(), End);
+                    DSuffix = "</" + std::string(Data.substr(Position + 1, NameEnd - Position - 1)) + ">";
+                    DHaveRoot = true;
+                    DBounds.assign(1, End);
+                    DLastCut = End;
+                }
+            }
+            else if(Markup == EMarkup::EndTag){
+                if(DDepth){
+                    DDepth--;
+                }
+                DDocumentEnd = !DDepth;
+            }
+            else if(Markup == EMarkup::EmptyTag){
+                DDocumentEnd = !DDepth;
+            }
+            if((DDepth == 1) && (Markup != EMarkup::Other) && DHaveRoot && (End > DLastCut)){
+                DLastCut = End;
+                if(DLastCut - DBounds.back() >= DChunkSize){
+                    DBounds.push_back(DLastCut);
+                }
+            }
+        }
+    }
+
+    // Parses the records of the next block on the worker threads. Returns
+    // false once the input is exhausted.
+    bool ParseBlock(){
+        if(DTailParsed){
+            return false;
+        }
+        while(true){
+            while(!DSourceEnd && (DBufferLength < DBuffer.size())){
+                std::size_t Length = DSource->ReadBlock(DBuffer.data() + DBufferLength, DBuffer.size() - DBufferLength);
+                if(!Length){
+                    DSourceEnd = true;
+                }
+                DBufferLength += Length;
+                if((DBufferLength == DBuffer.size()) && (DBuffer.size() < DBlockSize)){
+                    DBuffer.resize(std::min(DBuffer.size() * 2, DBlockSize));
+                }
+            }
+            Scan();
+            if(DHaveRoot && (DLastCut > DBounds.front())){
+                break;
+            }
+            if(DSourceEnd || DDocumentEnd){
+                return ParseTail();
+            }
+            // Not a single complete record fits, make room for a larger one
+            DBuffer.resize(DBuffer.size() * 2);
+        }
+        if(DBounds.back() < DLastCut){
+            DBounds.push_back(DLastCut);
+        }
+
+        std::size_t Chunks = DBounds.size() - 1;
+        DChunkRecords.resize(Chunks);
+        DChunkSuccess.assign(Chunks, 0);
+        ParallelUtils::RunParallel(Chunks, [&](std::size_t index){
+            TRecords &Records = DChunkRecords[index];
+            Records.clear();
+            std::string_view Chunk(DBuffer.data() + DBounds[index], DBounds[index + 1] - DBounds[index]);
+            CXMLReader Reader(std::make_shared< CWrappedChunkDataSource >(DPrefix, Chunk, DSuffix), std::min< std::size_t >(DChunkSize, 65536));
+            CRecordHandler Handler(DRecordName, Records);
+            DChunkSuccess[index] = Reader.Parse(Handler);
+            if(!DChunkSuccess[index]){
+                Records.resize(Handler.Complete());
+            }
+        });
+
+        // Carry the input after the last complete record over to the next block
+        std::memmove(DBuffer.data(), DBuffer.data() + DLastCut, DBufferLength - DLastCut);
+        DBufferLength -= DLastCut;
+        DScanPosition -= DLastCut;
+        DLastCut = 0;
+        DBounds.assign(1, 0);
+        DChunk = 0;
+        DRecord = 0;
+        return true;
+    }
+
+    // Parses what follows the last record, normally the root end tag, along
+    // with the rest of the source as the end of the document, so truncated
+    // input or anything after the root element is reported like CXMLReader
+    // does. Returns false once the tail has been parsed.
+    bool ParseTail(){
+        if(DTailParsed){
+            return false;
+        }
+        DTailParsed = true;
+        std::string_view Tail(DBuffer.data() + DBounds.front(), DBufferLength - DBounds.front());
+        DChunkRecords.assign(1, TRecords());
+        DChunkSuccess.assign(1, 0);
+        CXMLReader Reader(std::make_shared< CWrappedChunkDataSource >(DPrefix, Tail, std::string_view(), DSourceEnd ? nullptr : DSource), std::min< std::size_t >(DChunkSize, 65536));
+        CRecordHandler Handler(DRecordName, DChunkRecords[0]);
+        DChunkSuccess[0] = Reader.Parse(Handler);
+        DChunkRecords[0].resize(Handler.Complete());
+        DBufferLength = 0;
+        DChunk = 0;
+        DRecord = 0;
+        return true;
+    }
+
+    bool End(){
+        while(!DError){
+            // A chunk that failed to parse still returns the records before
+            // the error, the error is reported once they are read
+            while((DChunk < DChunkRecords.size()) && (DRecord >= DChunkRecords[DChunk].size())){
+                if(!DChunkSuccess[DChunk]){
+                    DError = true;
+                    return true;
+                }
+                DChunk++;
+                DRecord = 0;
+            }
+            if(DChunk < DChunkRecords.size()){
+                return false;
+            }
+            if(!ParseBlock()){
+                return true;
+            }
+        }
+        return true;
+    }
+
+    bool ReadRecord(std::vector< SXMLEntity > &record){
+        if(End()){
+            record.clear();
+            return false;
+        }
+        std::swap(record, DChunkRecords[DChunk][DRecord++]);
+        return true;
+    }
+};
+
+CParallelXMLReader::CParallelXMLReader(std::shared_ptr< CDataSource > src, const std::string &recordname, std::size_t threads, std::size_t chunksize)
+    : DImplementation(std::make_unique<SImplementation>(src, recordname, threads, chunksize)){
+
+}
+
+CParallelXMLReader::~CParallelXMLReader(){
+
+}
+
+bool CParallelXMLReader::End() const{
+    return DImplementation->End();
+}
+
+bool CParallelXMLReader::ReadRecord(std::vector< SXMLEntity > &record){
+    return DImplementation->ReadRecord(record);
+}
+
+bool CParallelXMLReader::Error() const{
+    return DImplementation->DError;
+}
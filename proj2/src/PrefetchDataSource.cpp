@@ -0,0 +1,150 @@
+#include "PrefetchDataSource.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+struct CPrefetchDataSource::SImplementation{
+    std::shared_ptr< CDataSource > DSource;
+    // Ring of buffers, DFilled of them starting at DReadSlot hold data
+    std::vector< std::vector< char > > DSlots;
+    std::vector< std::size_t > DLengths;
+    std::size_t DReadSlot = 0;
+    std::size_t DFilled = 0;
+    bool DSourceEnd = false;
+    bool DStop = false;
+    std::mutex DMutex;
+    std::condition_variable DChanged;
+    std::thread DThread;
+
+    // Reader side, DHolding is true while DReadSlot is being consumed
+    bool DHolding = false;
+    std::size_t DCurrentIndex = 0;
+    bool DEnd = false;
+    std::size_t DStalls = 0;
+
+    SImplementation(std::shared_ptr< CDataSource > src, std::size_t blocksize, std::size_t blockcount) : DSource(src){
+        // Two buffers are the minimum for the reader and the thread to overlap
+        DSlots.resize(std::max<std::size_t>(blockcount, 2));
+        for(auto &Slot : DSlots){
+            Slot.resize(std::max<std::size_t>(blocksize, 1));
+        }
+        DLengths.resize(DSlots.size());
+        DThread = std::thread(&SImplementation::Run, this);
+    }
+
+    ~SImplementation(){
+        {
+            std::lock_guard< std::mutex > Lock(DMutex);
+            DStop = true;
+        }
+        DChanged.notify_all();
+        DThread.join();
+    }
+
+    void Run(){
+        std::unique_lock< std::mutex > Lock(DMutex);
+        while(true){
+            DChanged.wait(Lock, [&]{ return DStop || (DFilled < DSlots.size()); });
+            if(DStop){
+                return;
+            }
+            // Slots past the filled ones are not touched by the reader
+            std::size_t Slot = (DReadSlot + DFilled) % DSlots.size();
+            Lock.unlock();
+            std::size_t Length = DSource->ReadBlock(DSlots[Slot].data(), DSlots[Slot].size());
+            Lock.lock();
+            if(!Length){
+                DSourceEnd = true;
+                DChanged.notify_all();
+                return;
+            }
+            DLengths[Slot] = Length;
+            DFilled++;
+            DChanged.notify_all();
+        }
+    }
+
+    // Makes sure at least one byte is available in DReadSlot
+    bool Fill(){
+        if(DHolding && (DCurrentIndex < DLengths[DReadSlot])){
+            return true;
+        }
+        if(DEnd){
+            return false;
+        }
+        std::unique_lock< std::mutex > Lock(DMutex);
+        if(DHolding){
+            DHolding = false;
+            DReadSlot = (DReadSlot + 1) % DSlots.size();
+            DFilled--;
+            DChanged.notify_all();
+        }
+        if(!DFilled && !DSourceEnd){
+            DStalls++;
+            DChanged.wait(Lock, [&]{ return DFilled || DSourceEnd; });
+        }
+        if(!DFilled){
+            DEnd = true;
+            return false;
+        }
+        DHolding = true;
+        DCurrentIndex = 0;
+        return true;
+    }
+
+    std::size_t ReadBlock(char *buf, std::size_t count){
+        std::size_t Total = 0;
+        while((Total < count) && Fill()){
+            std::size_t Length = std::min(count - Total, DLengths[DReadSlot] - DCurrentIndex);
+            std::memcpy(buf + Total, DSlots[DReadSlot].data() + DCurrentIndex, Length);
+            DCurrentIndex += Length;
+            Total += Length;
+        }
+        return Total;
+    }
+};
+
+CPrefetchDataSource::CPrefetchDataSource(std::shared_ptr< CDataSource > src, std::size_t blocksize, std::size_t blockcount)
+    : DImplementation(std::make_unique<SImplementation>(src, blocksize, blockcount)){
+
+}
+
+CPrefetchDataSource::~CPrefetchDataSource(){
+
+}
+
+std::size_t CPrefetchDataSource::Stalls() const noexcept{
+    return DImplementation->DStalls;
+}
+
+bool CPrefetchDataSource::End() const noexcept{
+    return !DImplementation->Fill();
+}
+
+bool CPrefetchDataSource::Get(char &ch) noexcept{
+    if(!DImplementation->Fill()){
+        return false;
+    }
+    ch = DImplementation->DSlots[DImplementation->DReadSlot][DImplementation->DCurrentIndex++];
+    return true;
+}
+
+bool CPrefetchDataSource::Peek(char &ch) noexcept{
+    if(!DImplementation->Fill()){
+        return false;
+    }
+    ch = DImplementation->DSlots[DImplementation->DReadSlot][DImplementation->DCurrentIndex];
+    return true;
+}
+
+bool CPrefetchDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    buf.resize(count);
+    buf.resize(DImplementation->ReadBlock(buf.data(), count));
+    return !buf.empty();
+}
+
+std::size_t CPrefetchDataSource::ReadBlock(char *buf, std::size_t count) noexcept{
+    return DImplementation->ReadBlock(buf, count);
+}
@@ -1,15 +1,116 @@
 #include "StringDataSink.h"
+#include <algorithm>
+#include <utility>
+
+namespace{
+
+constexpr std::size_t MinimumChunkSize = 4096;
+constexpr std::size_t MaximumChunkSize = 64 * 1024 * 1024;
+
+}
+
+void CStringDataSink::AddChunk(std::size_t capacity){
+    DChunks.emplace_back();
+    DChunks.back().reserve(std::max(capacity, std::min(std::max(DSize, MinimumChunkSize), MaximumChunkSize)));
+}
+
+void CStringDataSink::Combine() const{
+    if(DChunks.size() > 1){
+        // The combined chunk keeps room to grow so writes between calls to
+        // String() append to it, and it is only recombined once that fills
+        std::string Combined;
+        Combined.reserve(DSize + std::min(std::max(DSize, MinimumChunkSize), MaximumChunkSize));
+        for(auto &Chunk : DChunks){
+            Combined += Chunk;
+        }
+        DChunks.clear();
+        DChunks.push_back(std::move(Combined));
+    }
+}
 
 const std::string &CStringDataSink::String() const{
-    return DString;
+    if(DChunks.empty()){
+        DChunks.emplace_back();
+    }
+    Combine();
+    return DChunks.front();
+}
+
+std::size_t CStringDataSink::Size() const{
+    return DSize;
+}
+
+void CStringDataSink::Reserve(std::size_t size){
+    if(size <= DSize){
+        return;
+    }
+    if(DChunks.empty() || (DChunks.size() == 1)){
+        // The only chunk can still grow in place without copying much
+        if(DChunks.empty()){
+            DChunks.emplace_back();
+        }
+        DChunks.back().reserve(size);
+        return;
+    }
+    std::string &Last = DChunks.back();
+    if(Last.capacity() - Last.size() < size - DSize){
+        AddChunk(size - DSize);
+    }
+}
+
+std::string CStringDataSink::Take(){
+    Combine();
+    if(DChunks.empty()){
+        return std::string();
+    }
+    std::string Result = std::move(DChunks.front());
+    DChunks.clear();
+    DSize = 0;
+    return Result;
+}
+
+std::vector< std::string > CStringDataSink::TakeChunks(){
+    std::vector< std::string > Result;
+    Result.swap(DChunks);
+    DSize = 0;
+    return Result;
+}
+
+std::vector< struct iovec > CStringDataSink::IOVectors() const{
+    std::vector< struct iovec > Vectors;
+    for(auto &Chunk : DChunks){
+        if(!Chunk.empty()){
+            Vectors.push_back({const_cast< char * >(Chunk.data()), Chunk.size()});
+        }
+    }
+    return Vectors;
 }
 
 bool CStringDataSink::Put(const char &ch) noexcept{
-    DString += std::string(1,ch);
+    if(DChunks.empty() || (DChunks.back().size() == DChunks.back().capacity())){
+        AddChunk(1);
+    }
+    DChunks.back() += ch;
+    DSize++;
     return true;
 }
 
 bool CStringDataSink::Write(const std::vector<char> &buf) noexcept{
-    DString += std::string(buf.data(),buf.size());
+    return WriteBlock(buf.data(), buf.size());
+}
+
+bool CStringDataSink::WriteBlock(const char *buf, std::size_t count) noexcept{
+    if(DChunks.empty()){
+        AddChunk(count);
+    }
+    std::string &Last = DChunks.back();
+    std::size_t Length = std::min(count, Last.capacity() - Last.size());
+    Last.append(buf, Length);
+    if(Length < count){
+        // The rest goes into a new chunk instead of reallocating this one
+        AddChunk(count - Length);
+        DChunks.back().append(buf + Length, count - Length);
+    }
+    DSize += count;
     return true;
 }
@@ -1,40 +1,26 @@
 #include "StringDataSource.h"
+#include <utility>
 
-CStringDataSource::CStringDataSource(const std::string &str) : DString(str), DIndex(0){
+// The base is built over an empty view since DString does not exist yet, it is
+// pointed at DString once the string is in place
 
+CStringDataSource::CStringDataSource(const std::string &str) : CStringViewDataSource(std::string_view()), DString(str){
+    Rebind(DString);
 }
 
-bool CStringDataSource::End() const noexcept{
-    return DIndex >= DString.length();
+CStringDataSource::CStringDataSource(std::string &&str) : CStringViewDataSource(std::string_view()), DString(std::move(str)){
+    Rebind(DString);
 }
 
-bool CStringDataSource::Get(char &ch) noexcept{
-    if(DIndex < DString.length()){
-        ch = DString[DIndex];
-        DIndex++;
-        return true;
-    }
-    return false;
-}
-
-bool CStringDataSource::Peek(char &ch) noexcept{
-    if(DIndex < DString.length()){
-        ch = DString[DIndex];
-        return true;
-    }
-    return false;
+CStringDataSource::CStringDataSource(const CStringDataSource &source) : CStringViewDataSource(source), DString(source.DString){
+    Rebind(DString);
 }
 
-bool CStringDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
-    buf.clear();
-    while(buf.size() < count){
-        char TempChar;
-        if(Get(TempChar)){
-            buf.push_back(TempChar);
-        }
-        else{
-            break;
-        }
+CStringDataSource &CStringDataSource::operator=(const CStringDataSource &source){
+    if(this != &source){
+        CStringViewDataSource::operator=(source);
+        DString = source.DString;
+        Rebind(DString);
     }
-    return !buf.empty();
+    return *this;
 }
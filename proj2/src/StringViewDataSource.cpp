@@ -0,0 +1,52 @@
+#include "StringViewDataSource.h"
+#include <algorithm>
+#include <cstring>
+
+CStringViewDataSource::CStringViewDataSource(std::string_view str) : DString(str), DIndex(0){
+
+}
+
+CStringViewDataSource::CStringViewDataSource(const char *data, std::size_t length) : DString(data, length), DIndex(0){
+
+}
+
+void CStringViewDataSource::Rebind(std::string_view str) noexcept{
+    DString = str;
+}
+
+bool CStringViewDataSource::End() const noexcept{
+    return DIndex >= DString.length();
+}
+
+bool CStringViewDataSource::Get(char &ch) noexcept{
+    if(DIndex < DString.length()){
+        ch = DString[DIndex];
+        DIndex++;
+        return true;
+    }
+    return false;
+}
+
+bool CStringViewDataSource::Peek(char &ch) noexcept{
+    if(DIndex < DString.length()){
+        ch = DString[DIndex];
+        return true;
+    }
+    return false;
+}
+
+bool CStringViewDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    buf.resize(std::min(count, DString.length() - std::min(DIndex, DString.length())));
+    buf.resize(ReadBlock(buf.data(), buf.size()));
+    return !buf.empty();
+}
+
+std::size_t CStringViewDataSource::ReadBlock(char *buf, std::size_t count) noexcept{
+    if(DIndex >= DString.length()){
+        return 0;
+    }
+    std::size_t Length = std::min(count, DString.length() - DIndex);
+    std::memcpy(buf, DString.data() + DIndex, Length);
+    DIndex += Length;
+    return Length;
+}
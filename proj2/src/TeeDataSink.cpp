@@ -0,0 +1,199 @@
+#include "TeeDataSink.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+struct CTeeDataSink::SImplementation{
+    // A null block asks the child to flush its sink
+    using TBlock = std::shared_ptr< const std::vector< char > >;
+
+    struct SChild{
+        std::shared_ptr< CDataSink > DSink;
+        std::atomic< bool > DFailed{false};
+        std::deque< TBlock > DQueue;
+        bool DBusy = false;
+        std::thread DThread;
+    };
+
+    std::vector< std::unique_ptr< SChild > > DChildren;
+    bool DThreaded;
+    std::size_t DBlockSize;
+    std::size_t DQueueDepth;
+    std::shared_ptr< std::vector< char > > DPending;
+    std::mutex DMutex;
+    // DWork wakes the child threads, DDone the writer waiting on them
+    std::condition_variable DWork;
+    std::condition_variable DDone;
+    bool DStop = false;
+
+    SImplementation(std::vector< std::shared_ptr< CDataSink > > &sinks, bool threaded, std::size_t blocksize, std::size_t queuedepth)
+        : DThreaded(threaded), DBlockSize(std::max<std::size_t>(blocksize, 1)), DQueueDepth(std::max<std::size_t>(queuedepth, 1)){
+        for(auto &Sink : sinks){
+            DChildren.push_back(std::make_unique<SChild>());
+            DChildren.back()->DSink = Sink;
+            DChildren.back()->DFailed = !Sink;
+        }
+        if(DThreaded){
+            for(auto &Child : DChildren){
+                Child->DThread = std::thread(&SImplementation::Run, this, Child.get());
+            }
+        }
+    }
+
+    ~SImplementation(){
+        Flush();
+        if(DThreaded){
+            {
+                std::lock_guard< std::mutex > Lock(DMutex);
+                DStop = true;
+            }
+            DWork.notify_all();
+            for(auto &Child : DChildren){
+                Child->DThread.join();
+            }
+        }
+    }
+
+    bool AnyFailed() const{
+        for(auto &Child : DChildren){
+            if(Child->DFailed){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Run(SChild *child){
+        std::unique_lock< std::mutex > Lock(DMutex);
+        while(true){
+            DWork.wait(Lock, [&]{ return DStop || !child->DQueue.empty(); });
+            if(child->DQueue.empty()){
+                return;
+            }
+            TBlock Block = std::move(child->DQueue.front());
+            child->DQueue.pop_front();
+            child->DBusy = true;
+            Lock.unlock();
+            bool Success = Block ? child->DSink->WriteBlock(Block->data(), Block->size()) : child->DSink->Flush();
+            Block.reset();
+            Lock.lock();
+            child->DBusy = false;
+            if(!Success){
+                child->DFailed = true;
+                child->DQueue.clear();
+            }
+            DDone.notify_all();
+        }
+    }
+
+    // Queues a block for every working child, waiting while any of them is
+    // queuedepth blocks behind
+    void Enqueue(TBlock block){
+        std::unique_lock< std::mutex > Lock(DMutex);
+        DDone.wait(Lock, [&]{
+            return std::all_of(DChildren.begin(), DChildren.end(), [&](const std::unique_ptr< SChild > &child){
+                return child->DFailed || (child->DQueue.size() < DQueueDepth);
+            });
+        });
+        for(auto &Child : DChildren){
+            if(!Child->DFailed){
+                Child->DQueue.push_back(block);
+            }
+        }
+        DWork.notify_all();
+    }
+
+    void SubmitPending(){
+        if(DPending && !DPending->empty()){
+            Enqueue(std::move(DPending));
+        }
+        DPending.reset();
+    }
+
+    bool WriteBlock(const char *buf, std::size_t count){
+        if(!DThreaded){
+            for(auto &Child : DChildren){
+                if(!Child->DFailed && !Child->DSink->WriteBlock(buf, count)){
+                    Child->DFailed = true;
+                }
+            }
+            return !AnyFailed();
+        }
+        if(!DPending && (count >= DBlockSize)){
+            // The caller's memory is only valid during the call, so large
+            // blocks are copied once and shared by all the children
+            Enqueue(std::make_shared< const std::vector< char > >(buf, buf + count));
+            return !AnyFailed();
+        }
+        while(count){
+            if(!DPending){
+                DPending = std::make_shared< std::vector< char > >();
+                DPending->reserve(DBlockSize);
+            }
+            std::size_t Length = std::min(count, DBlockSize - DPending->size());
+            DPending->insert(DPending->end(), buf, buf + Length);
+            buf += Length;
+            count -= Length;
+            if(DPending->size() == DBlockSize){
+                SubmitPending();
+            }
+        }
+        return !AnyFailed();
+    }
+
+    bool Flush(){
+        if(!DThreaded){
+            for(auto &Child : DChildren){
+                if(!Child->DFailed && !Child->DSink->Flush()){
+                    Child->DFailed = true;
+                }
+            }
+            return !AnyFailed();
+        }
+        SubmitPending();
+        Enqueue(nullptr);
+        std::unique_lock< std::mutex > Lock(DMutex);
+        DDone.wait(Lock, [&]{
+            return std::all_of(DChildren.begin(), DChildren.end(), [](const std::unique_ptr< SChild > &child){
+                return child->DQueue.empty() && !child->DBusy;
+            });
+        });
+        return !AnyFailed();
+    }
+};
+
+CTeeDataSink::CTeeDataSink(std::vector< std::shared_ptr< CDataSink > > sinks, bool threaded, std::size_t blocksize, std::size_t queuedepth)
+    : DImplementation(std::make_unique<SImplementation>(sinks, threaded, blocksize, queuedepth)){
+
+}
+
+CTeeDataSink::~CTeeDataSink(){
+
+}
+
+std::size_t CTeeDataSink::ChildCount() const noexcept{
+    return DImplementation->DChildren.size();
+}
+
+bool CTeeDataSink::ChildFailed(std::size_t index) const noexcept{
+    return (index < DImplementation->DChildren.size()) && DImplementation->DChildren[index]->DFailed;
+}
+
+bool CTeeDataSink::Put(const char &ch) noexcept{
+    return DImplementation->WriteBlock(&ch, 1);
+}
+
+bool CTeeDataSink::Write(const std::vector<char> &buf) noexcept{
+    return DImplementation->WriteBlock(buf.data(), buf.size());
+}
+
+bool CTeeDataSink::WriteBlock(const char *buf, std::size_t count) noexcept{
+    return DImplementation->WriteBlock(buf, count);
+}
+
+bool CTeeDataSink::Flush() noexcept{
+    return DImplementation->Flush();
+}
@@ -0,0 +1,22 @@
+#include "XMLNameTable.h"
+
+std::string_view CXMLNameTable::Intern(std::string_view name){
+    auto Search = DIndex.find(name);
+    if(Search != DIndex.end()){
+        return *Search;
+    }
+    // Strings in a deque never move, so views of them stay valid
+    DStorage.emplace_back(name);
+    std::string_view Interned = DStorage.back();
+    DIndex.insert(Interned);
+    return Interned;
+}
+
+std::string_view CXMLNameTable::Find(std::string_view name) const{
+    auto Search = DIndex.find(name);
+    return Search != DIndex.end() ? *Search : std::string_view();
+}
+
+std::size_t CXMLNameTable::Size() const{
+    return DStorage.size();
+}
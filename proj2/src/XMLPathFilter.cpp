@@ -0,0 +1,113 @@
+#include "XMLPathFilter.h"
+#include <utility>
+
+CXMLPathFilter::CXMLPathFilter(const std::string &path, CXMLHandler &handler) : DHandler(handler){
+    std::size_t Index = 0;
+    DValid = !path.empty() && (path[0] == '/');
+    while(DValid && (Index < path.size())){
+        if(path[Index++] != '/'){
+            DValid = false;
+            break;
+        }
+        SStep Step;
+        while((Index < path.size()) && (path[Index] != '/') && (path[Index] != '[')){
+            Step.DName += path[Index++];
+        }
+        while(DValid && (Index < path.size()) && (path[Index] == '[')){
+            SPredicate Predicate{"", "", false};
+            Index++;
+            if((Index >= path.size()) || (path[Index++] != '@')){
+                DValid = false;
+                break;
+            }
+            while((Index < path.size()) && (path[Index] != '=') && (path[Index] != ']')){
+                Predicate.DName += path[Index++];
+            }
+            if((Index < path.size()) && (path[Index] == '=')){
+                Index++;
+                char Quote = Index < path.size() ? path[Index++] : '\0';
+                if((Quote != '\'') && (Quote != '"')){
+                    DValid = false;
+                    break;
+                }
+                std::size_t ValueEnd = path.find(Quote, Index);
+                if(ValueEnd == std::string::npos){
+                    DValid = false;
+                    break;
+                }
+                Predicate.DValue = path.substr(Index, ValueEnd - Index);
+                Predicate.DHasValue = true;
+                Index = ValueEnd + 1;
+            }
+            if((Index >= path.size()) || (path[Index++] != ']') || Predicate.DName.empty()){
+                DValid = false;
+                break;
+            }
+            Step.DPredicates.push_back(std::move(Predicate));
+        }
+        if(Step.DName.empty()){
+            DValid = false;
+        }
+        DSteps.push_back(std::move(Step));
+    }
+}
+
+bool CXMLPathFilter::StepMatches(const SStep &step, std::string_view name, const std::vector< SXMLAttributeView > &attributes) const{
+    if((step.DName != "*") && (step.DName != name)){
+        return false;
+    }
+    for(auto &Predicate : step.DPredicates){
+        bool Found = false;
+        for(auto &Attribute : attributes){
+            if(Attribute.DName == Predicate.DName){
+                Found = !Predicate.DHasValue || (Attribute.DValue == Predicate.DValue);
+                break;
+            }
+        }
+        if(!Found){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CXMLPathFilter::Valid() const{
+    return DValid;
+}
+
+bool CXMLPathFilter::Matching() const{
+    return DValid && (DMatched == DSteps.size()) && (DDepth >= DMatched);
+}
+
+void CXMLPathFilter::OnStart(std::string_view name, const std::vector< SXMLAttributeView > &attributes){
+    if(Matching()){
+        DDepth++;
+        DHandler.OnStart(name, attributes);
+        return;
+    }
+    // Only a child of the deepest matched element can match the next step,
+    // anything else starts a subtree that is skipped until its end
+    if(DValid && (DDepth == DMatched) && StepMatches(DSteps[DMatched], name, attributes)){
+        DMatched++;
+        if(DMatched == DSteps.size()){
+            DHandler.OnStart(name, attributes);
+        }
+    }
+    DDepth++;
+}
+
+void CXMLPathFilter::OnEnd(std::string_view name){
+    if(Matching()){
+        DHandler.OnEnd(name);
+    }
+    if(DDepth == DMatched){
+        DMatched--;
+    }
+    DDepth--;
+}
+
+void CXMLPathFilter::OnCharData(std::string_view data){
+    if(Matching()){
+        DHandler.OnCharData(data);
+    }
+}
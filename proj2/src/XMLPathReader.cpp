@@ -0,0 +1,101 @@
+#include "XMLPathReader.h"
+#include "XMLPathFilter.h"
+#include "XMLReader.h"
+#include <utility>
+
+struct CXMLPathReader::SImplementation : public CXMLHandler{
+    CXMLReader DReader;
+    CXMLPathFilter DFilter;
+    // Entities waiting to be read are DEntities[DHead, DCount), the entities
+    // past DCount are kept so their strings can be reused
+    std::vector< SXMLEntity > DEntities;
+    std::size_t DHead = 0;
+    std::size_t DCount = 0;
+    bool DFinished = false;
+
+    SImplementation(std::shared_ptr< CDataSource > src, const std::string &path, std::size_t chunksize)
+        : DReader(src, chunksize), DFilter(path, *this){
+        DFinished = !DFilter.Valid();
+    }
+
+    SXMLEntity &PushEntity(SXMLEntity::EType type, std::string_view name){
+        if(DCount == DEntities.size()){
+            DEntities.emplace_back();
+        }
+        SXMLEntity &Entity = DEntities[DCount++];
+        Entity.DType = type;
+        Entity.DNameData.assign(name.data(), name.size());
+        Entity.DAttributes.clear();
+        return Entity;
+    }
+
+    void OnStart(std::string_view name, const std::vector< SXMLAttributeView > &attributes) override{
+        PushEntity(SXMLEntity::EType::StartElement, name).DAttributes.Assign(attributes.size(), [&](std::size_t index){
+            return std::make_pair(attributes[index].DName, attributes[index].DValue);
+        });
+    }
+
+    void OnEnd(std::string_view name) override{
+        PushEntity(SXMLEntity::EType::EndElement, name);
+    }
+
+    void OnCharData(std::string_view data) override{
+        // Character data split by the parser is merged back into one entity
+        if((DCount > DHead) && (DEntities[DCount - 1].DType == SXMLEntity::EType::CharData)){
+            DEntities[DCount - 1].DNameData.append(data.data(), data.size());
+        }
+        else{
+            PushEntity(SXMLEntity::EType::CharData, data);
+        }
+    }
+
+    // The front entity is complete unless it is character data that the
+    // next chunk may continue
+    bool FrontReady() const{
+        if(DHead == DCount){
+            return false;
+        }
+        return DFinished || (DHead + 1 < DCount) || (DEntities[DHead].DType != SXMLEntity::EType::CharData);
+    }
+
+    bool ReadEntity(SXMLEntity &entity, bool skipcdata){
+        while(true){
+            while(!FrontReady() && !DFinished){
+                DFinished = !DReader.ParseNext(DFilter);
+            }
+            if(DHead == DCount){
+                return false;
+            }
+            // The caller's entity takes the queue slot so its capacity is reused
+            std::swap(entity, DEntities[DHead++]);
+            if(DHead == DCount){
+                DHead = 0;
+                DCount = 0;
+            }
+            if(!skipcdata || (entity.DType != SXMLEntity::EType::CharData)){
+                return true;
+            }
+        }
+    }
+};
+
+CXMLPathReader::CXMLPathReader(std::shared_ptr< CDataSource > src, const std::string &path, std::size_t chunksize)
+    : DImplementation(std::make_unique<SImplementation>(src, path, chunksize)){
+
+}
+
+CXMLPathReader::~CXMLPathReader(){
+
+}
+
+bool CXMLPathReader::Valid() const{
+    return DImplementation->DFilter.Valid();
+}
+
+bool CXMLPathReader::End() const{
+    return DImplementation->DFinished && (DImplementation->DHead == DImplementation->DCount);
+}
+
+bool CXMLPathReader::ReadEntity(SXMLEntity &entity, bool skipcdata){
+    return DImplementation->ReadEntity(entity, skipcdata);
+}
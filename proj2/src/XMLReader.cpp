@@ -1,19 +1,47 @@
 #include "XMLReader.h"
-#include "StringDataSource.h"
 #include <expat.h>
-#include <queue>
+#include <algorithm>
+#include <cstring>
+#include <memory_resource>
 #include <vector>
 #include <memory>
 #include <string>
 #include <utility>
 
 struct CXMLReader::SImplementation {
+    // Queued entity whose strings live in arena
+    struct SQueuedEntity {
+        SXMLEntity::EType DType;
+        std::string_view DName;
+        std::string_view DData;
+        std::size_t DAttributeBegin;
+        std::size_t DAttributeEnd;
+    };
+
     std::shared_ptr<CDataSource> dataSource;
     XML_Parser xmlParser;
-    std::queue<SXMLEntity> entityQueue;
+    // Element and attribute names of the document, shared by all entities
+    CXMLNameTable nameTable;
+    // Entities parsed but not yet read are entityQueue[queueHead, size), their
+    // attributes are ranges of queuedAttributes. Both vectors keep their
+    // capacity and the arena is reset wholesale each time the queue drains.
+    std::vector<SQueuedEntity> entityQueue;
+    std::size_t queueHead = 0;
+    std::vector<SXMLAttributeView> queuedAttributes;
+    std::vector<char> arenaBuffer;
+    std::pmr::monotonic_buffer_resource arena;
+    // Consecutive character data is collected here until the next element
+    std::string pendingCharData;
+    // Receives the parse events instead of entityQueue while Parse runs
+    CXMLHandler* handler = nullptr;
+    std::vector<SXMLAttributeView> attributeViews;
+    bool finished = false;
+    // Number of bytes read from the source into expat's buffer at a time
+    std::size_t chunkSize;
 
-    explicit SImplementation(std::shared_ptr<CDataSource> source)
-        : dataSource(std::move(source)) {
+    SImplementation(std::shared_ptr<CDataSource> source, std::size_t chunksize)
+        : dataSource(std::move(source)), arenaBuffer(2 * std::max<std::size_t>(chunksize, 4096)),
+          arena(arenaBuffer.data(), arenaBuffer.size()), chunkSize(chunksize ? chunksize : 1) {
         xmlParser = XML_ParserCreate(nullptr);
         XML_SetUserData(xmlParser, this);
         XML_SetElementHandler(xmlParser, StartElementHandler, EndElementHandler);
@@ -25,94 +53,209 @@ struct CXMLReader::SImplementation {
     }
 
     bool IsEnd() const {
-        return dataSource->End() && entityQueue.empty();
+        return dataSource->End() && (queueHead == entityQueue.size()) && pendingCharData.empty();
+    }
+
+    // Copies a string into the arena
+    std::string_view Store(std::string_view value) {
+        if (value.empty()) {
+            return std::string_view();
+        }
+        char* data = static_cast<char*>(arena.allocate(value.size(), 1));
+        std::memcpy(data, value.data(), value.size());
+        return std::string_view(data, value.size());
+    }
+
+    void PopEntity() {
+        if (++queueHead == entityQueue.size()) {
+            entityQueue.clear();
+            queuedAttributes.clear();
+            queueHead = 0;
+            arena.release();
+        }
+    }
+
+    // Entities are assigned into the caller's objects so their strings and
+    // vectors keep the capacity they already have
+    void CopyEntity(SXMLEntity& entity, const SQueuedEntity& source) {
+        entity.DType = source.DType;
+        if (source.DType == SXMLEntity::EType::CharData) {
+            entity.DNameData.assign(source.DData.data(), source.DData.size());
+        }
+        else {
+            entity.DNameData.assign(source.DName.data(), source.DName.size());
+        }
+        entity.DAttributes.Assign(source.DAttributeEnd - source.DAttributeBegin, [&](std::size_t index) {
+            const auto& attribute = queuedAttributes[source.DAttributeBegin + index];
+            return std::make_pair(attribute.DName, attribute.DValue);
+        });
     }
 
-    bool ReadEntity(SXMLEntity& entity, bool skipCData) {
-        RefillEntityQueue();
+    void CopyEntity(SXMLInternedEntity& entity, const SQueuedEntity& source) {
+        entity.DType = source.DType;
+        entity.DName = source.DName;
+        entity.DData.assign(source.DData.data(), source.DData.size());
+        entity.DAttributes.resize(source.DAttributeEnd - source.DAttributeBegin);
+        for (std::size_t index = 0; index < entity.DAttributes.size(); index++) {
+            const auto& attribute = queuedAttributes[source.DAttributeBegin + index];
+            entity.DAttributes[index].first = attribute.DName;
+            entity.DAttributes[index].second.assign(attribute.DValue.data(), attribute.DValue.size());
+        }
+    }
 
-        while (!entityQueue.empty()) {
-            const auto& frontEntity = entityQueue.front();
+    template <typename TEntity>
+    bool ReadEntity(TEntity& entity, bool skipCData) {
+        while (true) {
+            while ((queueHead == entityQueue.size()) && ParseChunk()) {
+            }
+            if (queueHead == entityQueue.size()) {
+                return false;
+            }
+            const auto& frontEntity = entityQueue[queueHead];
 
             if (skipCData && frontEntity.DType == SXMLEntity::EType::CharData) {
-                entityQueue.pop();
+                PopEntity();
                 continue;
             }
 
-            entity = frontEntity;
-            entityQueue.pop();
+            CopyEntity(entity, frontEntity);
+            PopEntity();
             return true;
         }
-        return false;
     }
 
-private:
-    void RefillEntityQueue() {
-        if (entityQueue.empty() && !dataSource->End()) {
-            std::vector<char> buffer(1024);
-            if (dataSource->Read(buffer, buffer.size())) {
-                XML_Parse(xmlParser, buffer.data(), buffer.size(), 0);
-            } else {
-                XML_Parse(xmlParser, nullptr, 0, XML_TRUE); // Signal end of parsing
+    // Passes the entities already queued for ReadEntity to the handler
+    void DrainQueue(CXMLHandler& eventHandler) {
+        FlushCharData();
+        while (queueHead < entityQueue.size()) {
+            const auto& frontEntity = entityQueue[queueHead];
+            switch (frontEntity.DType) {
+                case SXMLEntity::EType::StartElement:
+                    attributeViews.assign(queuedAttributes.begin() + frontEntity.DAttributeBegin, queuedAttributes.begin() + frontEntity.DAttributeEnd);
+                    eventHandler.OnStart(frontEntity.DName, attributeViews);
+                    break;
+                case SXMLEntity::EType::EndElement:
+                    eventHandler.OnEnd(frontEntity.DName);
+                    break;
+                default:
+                    eventHandler.OnCharData(frontEntity.DData);
+                    break;
             }
+            PopEntity();
+        }
+    }
+
+    bool Parse(CXMLHandler& eventHandler) {
+        DrainQueue(eventHandler);
+        handler = &eventHandler;
+        bool success = true;
+        while (!finished) {
+            success = ParseChunk();
         }
+        handler = nullptr;
+        return success;
     }
 
-    void HandleStartElement(const std::string& name, const std::vector<std::string>& attributes) {
-        SXMLEntity entity;
-        entity.DNameData = name;
-        entity.DType = SXMLEntity::EType::StartElement;
+    bool ParseNext(CXMLHandler& eventHandler) {
+        DrainQueue(eventHandler);
+        handler = &eventHandler;
+        bool success = ParseChunk();
+        handler = nullptr;
+        return success && !finished;
+    }
 
-        for (size_t i = 0; i < attributes.size(); i += 2) {
-            entity.SetAttribute(attributes[i], attributes[i + 1]);
+private:
+    // Feeds the next chunk of input to expat, signalling the end of the
+    // document once the source is exhausted. Returns false on a parse error.
+    bool ParseChunk() {
+        if (finished) {
+            return false;
+        }
+        // Read straight into expat's own buffer, which it reuses between calls
+        void* buffer = XML_GetBuffer(xmlParser, chunkSize);
+        if (!buffer) {
+            finished = true;
+            FlushCharData();
+            return false;
+        }
+        std::size_t length = dataSource->ReadBlock(static_cast<char*>(buffer), chunkSize);
+        if (!length) {
+            finished = true; // Signal end of parsing
+        }
+        bool success = XML_ParseBuffer(xmlParser, length, finished) == XML_STATUS_OK;
+        if (!success) {
+            finished = true;
         }
+        if (finished) {
+            FlushCharData();
+        }
+        return success;
+    }
 
-        entityQueue.push(std::move(entity));
+    void PushEntity(SXMLEntity::EType type, std::string_view name, std::string_view data) {
+        entityQueue.push_back({type, name, data, queuedAttributes.size(), queuedAttributes.size()});
     }
 
-    void HandleEndElement(const std::string& name) {
-        SXMLEntity entity;
-        entity.DNameData = name;
-        entity.DType = SXMLEntity::EType::EndElement;
-        entityQueue.push(std::move(entity));
+    // Queues the collected character data as one entity
+    void FlushCharData() {
+        if (!pendingCharData.empty()) {
+            PushEntity(SXMLEntity::EType::CharData, std::string_view(), Store(pendingCharData));
+            pendingCharData.clear();
+        }
     }
 
-    void HandleCharacterData(const std::string& data) {
-        if (!entityQueue.empty() && entityQueue.back().DType == SXMLEntity::EType::CharData) {
-            entityQueue.back().DNameData += data; // Merge consecutive character data
-        } else {
-            SXMLEntity entity;
-            entity.DType = SXMLEntity::EType::CharData;
-            entity.DNameData = data;
-            entityQueue.push(std::move(entity));
+    void HandleStartElement(const XML_Char* name, const XML_Char** attributes) {
+        FlushCharData();
+        PushEntity(SXMLEntity::EType::StartElement, nameTable.Intern(name), std::string_view());
+        for (auto attr = attributes; *attr; attr += 2) {
+            queuedAttributes.push_back({nameTable.Intern(attr[0]), Store(attr[1])});
         }
+        entityQueue.back().DAttributeEnd = queuedAttributes.size();
+    }
+
+    void HandleEndElement(const XML_Char* name) {
+        FlushCharData();
+        PushEntity(SXMLEntity::EType::EndElement, nameTable.Intern(name), std::string_view());
+    }
+
+    void HandleCharacterData(std::string_view data) {
+        pendingCharData += data; // Merge consecutive character data
     }
 
     static void StartElementHandler(void* context, const XML_Char* name, const XML_Char** attributes) {
         auto* impl = static_cast<SImplementation*>(context);
-        std::vector<std::string> attrs;
-
-        for (auto attr = attributes; *attr; attr += 2) {
-            attrs.emplace_back(attr[0]);
-            attrs.emplace_back(attr[1]);
+        if (impl->handler) {
+            impl->attributeViews.clear();
+            for (auto attr = attributes; *attr; attr += 2) {
+                impl->attributeViews.push_back({impl->nameTable.Intern(attr[0]), attr[1]});
+            }
+            impl->handler->OnStart(impl->nameTable.Intern(name), impl->attributeViews);
+            return;
         }
-
-        impl->HandleStartElement(name, attrs);
+        impl->HandleStartElement(name, attributes);
     }
 
     static void EndElementHandler(void* context, const XML_Char* name) {
         auto* impl = static_cast<SImplementation*>(context);
+        if (impl->handler) {
+            impl->handler->OnEnd(impl->nameTable.Intern(name));
+            return;
+        }
         impl->HandleEndElement(name);
     }
 
     static void CharacterDataHandler(void* context, const XML_Char* data, int length) {
         auto* impl = static_cast<SImplementation*>(context);
-        impl->HandleCharacterData(std::string(data, length));
+        if (impl->handler) {
+            impl->handler->OnCharData(std::string_view(data, length));
+            return;
+        }
+        impl->HandleCharacterData(std::string_view(data, length));
     }
 };
 
-CXMLReader::CXMLReader(std::shared_ptr<CDataSource> source)
-    : DImplementation(std::make_unique<SImplementation>(std::move(source))) {}
+CXMLReader::CXMLReader(std::shared_ptr<CDataSource> source, std::size_t chunksize)
+    : DImplementation(std::make_unique<SImplementation>(std::move(source), chunksize)) {}
 
 CXMLReader::~CXMLReader() = default;
 
@@ -122,4 +265,20 @@ bool CXMLReader::End() const {
 
 bool CXMLReader::ReadEntity(SXMLEntity& entity, bool skipCData) {
     return DImplementation->ReadEntity(entity, skipCData);
-}
\ No newline at end of file
+}
+
+bool CXMLReader::ReadEntity(SXMLInternedEntity& entity, bool skipCData) {
+    return DImplementation->ReadEntity(entity, skipCData);
+}
+
+CXMLNameTable& CXMLReader::NameTable() {
+    return DImplementation->nameTable;
+}
+
+bool CXMLReader::Parse(CXMLHandler& handler) {
+    return DImplementation->Parse(handler);
+}
+
+bool CXMLReader::ParseNext(CXMLHandler& handler) {
+    return DImplementation->ParseNext(handler);
+}
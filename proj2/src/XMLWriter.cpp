@@ -1,76 +1,330 @@
 #include "XMLWriter.h"
 #include "StringDataSink.h"
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+bool IsSpecialChar(char ch) {
+    return (ch == '&') || (ch == '<') || (ch == '>') || (ch == '\"') || (ch == '\'');
+}
+
+// Returns the index of the first character that needs escaping, or length
+// if there is none. Sixteen characters are checked at a time with SSE2.
+std::size_t FindSpecialChar(const char* data, std::size_t length) {
+    std::size_t index = 0;
+#if defined(__SSE2__)
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i quot = _mm_set1_epi8('\"');
+    const __m128i apos = _mm_set1_epi8('\'');
+    for (; index + 16 <= length; index += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+        __m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, lt)),
+                                       _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, gt), _mm_cmpeq_epi8(chunk, quot)),
+                                                    _mm_cmpeq_epi8(chunk, apos)));
+        int mask = _mm_movemask_epi8(matches);
+        if (mask) {
+            return index + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; index < length; index++) {
+        if (IsSpecialChar(data[index])) {
+            break;
+        }
+    }
+    return index;
+}
+
+bool IsWhitespace(char ch) {
+    return (ch == ' ') || (ch == '\t') || (ch == '\n') || (ch == '\r');
+}
+
+}
 
 struct CXMLWriter::SImplementation {
+    // Layout state of an element that has been started but not ended
+    struct SOpenElement {
+        std::string DName;
+        bool DHasChildren;
+        // Once an element gets text, the rest of it and everything started
+        // inside it afterwards are written without indentation
+        bool DMixed;
+    };
+
     std::shared_ptr<CDataSink> sink;
+    std::size_t flushThreshold;
+    EFormat format;
+    bool collapseEmpty;
+    // Output not yet written to the sink, reused so entities do not allocate
+    std::string buffer;
+    std::vector<SOpenElement> openElements;
+    // Whitespace only character data of an indented element, replaced by
+    // the indentation if an element or end tag follows and written as it is
+    // if text follows
+    std::string heldWhitespace;
+    bool started = false;
+    // The '>' of the last start tag is held back until the next entity
+    // shows whether the element is empty and can be closed with "/>"
+    bool pendingStart = false;
+    // Canonical text is written a word at a time. Whitespace becomes a single
+    // space before the next word or child element, except at the start or
+    // end of an element's content.
+    bool contentStart = true;
+    bool pendingSpace = false;
+    std::vector<const CXMLAttributeList::TAttribute*> sortedAttributes;
+
+    SImplementation(std::shared_ptr<CDataSink> sink, std::size_t flushthreshold, EFormat format, bool collapseempty)
+        : sink(std::move(sink)), flushThreshold(flushthreshold), format(format),
+          collapseEmpty(collapseempty && (format != EFormat::Canonical)) {
+        buffer.reserve(flushthreshold + 1024);
+    }
 
-    explicit SImplementation(std::shared_ptr<CDataSink> sink)
-        : sink(std::move(sink)) {}
-
-    // Helper function to escape special XML characters
-    std::string EscapeSpecialChars(const std::string& input) {
-        std::string result;
-        for (char ch : input) {
-            switch (ch) {
-                case '&':  result += "&amp;"; break;
-                case '<':  result += "&lt;"; break;
-                case '>':  result += "&gt;"; break;
-                case '\"': result += "&quot;"; break;
-                case '\'': result += "&apos;"; break;
-                default:   result += ch; break;
+    // Appends input to the buffer, escaping special XML characters. Runs
+    // without special characters are copied in bulk.
+    void AppendEscaped(std::string_view input) {
+        buffer.reserve(buffer.size() + input.size());
+        std::size_t start = 0;
+        while (true) {
+            std::size_t special = start + FindSpecialChar(input.data() + start, input.size() - start);
+            buffer.append(input.data() + start, special - start);
+            if (special == input.size()) {
+                break;
             }
+            switch (input[special]) {
+                case '&':  buffer += "&amp;"; break;
+                case '<':  buffer += "&lt;"; break;
+                case '>':  buffer += "&gt;"; break;
+                case '\"': buffer += "&quot;"; break;
+                default:   buffer += "&apos;"; break;
+            }
+            start = special + 1;
+        }
+    }
+
+    void AppendAttribute(const CXMLAttributeList::TAttribute& attribute) {
+        buffer += ' ';
+        AppendEscaped(attribute.first);
+        buffer += "=\"";
+        AppendEscaped(attribute.second);
+        buffer += '\"';
+    }
+
+    void AppendAttributes(const CXMLAttributeList& attributes) {
+        if (format != EFormat::Canonical) {
+            for (const auto& attribute : attributes) {
+                AppendAttribute(attribute);
+            }
+            return;
+        }
+        sortedAttributes.clear();
+        for (const auto& attribute : attributes) {
+            sortedAttributes.push_back(&attribute);
+        }
+        std::sort(sortedAttributes.begin(), sortedAttributes.end(), [](auto left, auto right) {
+            return left->first < right->first;
+        });
+        for (auto attribute : sortedAttributes) {
+            AppendAttribute(*attribute);
+        }
+    }
+
+    bool Indenting() const {
+        return (format == EFormat::Indented) && (openElements.empty() || !openElements.back().DMixed);
+    }
+
+    // Starts a new line indented to depth, except at the start of the output
+    void AppendIndent(std::size_t depth) {
+        if (started) {
+            buffer += '\n';
+            buffer.append(2 * depth, ' ');
+        }
+    }
+
+    void ClosePendingStart() {
+        if (pendingStart) {
+            buffer += '>';
+            pendingStart = false;
         }
-        return result;
     }
 
-    // Write a string to the data sink
-    void WriteToSink(const std::string& data) {
-        sink->Write(std::vector<char>(data.begin(), data.end()));
+    // Called before a start or complete element is written
+    void BeginElement() {
+        ClosePendingStart();
+        if (pendingSpace && !contentStart && !openElements.empty()) {
+            buffer += ' ';
+        }
+        pendingSpace = false;
+        if (Indenting()) {
+            heldWhitespace.clear();
+            AppendIndent(openElements.size());
+        }
+        if (!openElements.empty()) {
+            openElements.back().DHasChildren = true;
+        }
+        started = true;
     }
 
     // Write a start element
-    void StartElement(const std::string& name, const std::vector<SXMLEntity::TAttribute>& attributes) {
-        std::string element = "<" + EscapeSpecialChars(name);
-        for (const auto& [key, value] : attributes) {
-            element += " " + EscapeSpecialChars(key) + "=\"" + EscapeSpecialChars(value) + "\"";
+    void StartElement(const std::string& name, const CXMLAttributeList& attributes) {
+        BeginElement();
+        buffer += '<';
+        AppendEscaped(name);
+        AppendAttributes(attributes);
+        if (collapseEmpty) {
+            pendingStart = true;
         }
-        element += ">";
-        WriteToSink(element);
+        else {
+            buffer += '>';
+        }
+        bool mixed = !openElements.empty() && openElements.back().DMixed;
+        openElements.push_back({name, false, mixed});
+        contentStart = true;
     }
 
-    // Write an end element
-    void EndElement(const std::string& name) {
-        std::string element = "</" + EscapeSpecialChars(name) + ">";
-        WriteToSink(element);
+    // Write an end element, returns false if it does not match the open
+    // element. An end element without any open element is written as is.
+    bool EndElement(const std::string& name) {
+        if (!openElements.empty() && (openElements.back().DName != name)) {
+            return false;
+        }
+        pendingSpace = false;
+        contentStart = false;
+        heldWhitespace.clear();
+        if (pendingStart) {
+            buffer += "/>";
+            pendingStart = false;
+            openElements.pop_back();
+            return true;
+        }
+        if (!openElements.empty()) {
+            if (Indenting() && openElements.back().DHasChildren) {
+                AppendIndent(openElements.size() - 1);
+            }
+            openElements.pop_back();
+        }
+        buffer += "</";
+        AppendEscaped(name);
+        buffer += '>';
+        started = true;
+        return true;
     }
 
     // Write a complete (self-closing) element
-    void CompleteElement(const std::string& name, const std::vector<SXMLEntity::TAttribute>& attributes) {
-        std::string element = "<" + EscapeSpecialChars(name);
-        for (const auto& [key, value] : attributes) {
-            element += " " + EscapeSpecialChars(key) + "=\"" + EscapeSpecialChars(value) + "\"";
+    void CompleteElement(const std::string& name, const CXMLAttributeList& attributes) {
+        BeginElement();
+        buffer += '<';
+        AppendEscaped(name);
+        AppendAttributes(attributes);
+        if (format == EFormat::Canonical) {
+            // Canonical XML writes empty elements as a start and end tag pair
+            buffer += "></";
+            AppendEscaped(name);
+            buffer += '>';
+        }
+        else {
+            buffer += "/>";
         }
-        element += "/>";
-        WriteToSink(element);
+        contentStart = false;
     }
 
     // Write character data
     void CharData(const std::string& data) {
-        WriteToSink(EscapeSpecialChars(data));
+        if (format == EFormat::Raw) {
+            if (!data.empty()) {
+                ClosePendingStart();
+            }
+            AppendEscaped(data);
+            started = true;
+            return;
+        }
+        if (format == EFormat::Canonical) {
+            NormalizedCharData(data);
+            return;
+        }
+        bool whitespace = std::all_of(data.begin(), data.end(), IsWhitespace);
+        if (whitespace && Indenting()) {
+            // Formatting whitespace is replaced by the writer's own unless
+            // text follows
+            if (!openElements.empty()) {
+                heldWhitespace += data;
+            }
+            return;
+        }
+        if (whitespace && (format == EFormat::Compact)) {
+            return;
+        }
+        ClosePendingStart();
+        if (!openElements.empty()) {
+            openElements.back().DMixed = true;
+        }
+        buffer += heldWhitespace;
+        heldWhitespace.clear();
+        AppendEscaped(data);
+        started = true;
+    }
+
+    // Writes the words of data separated by single spaces, the whitespace
+    // before the first word of an element's content is dropped
+    void NormalizedCharData(std::string_view data) {
+        std::size_t index = 0;
+        while (index < data.size()) {
+            if (IsWhitespace(data[index])) {
+                pendingSpace = true;
+                index++;
+                continue;
+            }
+            std::size_t wordEnd = index;
+            while ((wordEnd < data.size()) && !IsWhitespace(data[wordEnd])) {
+                wordEnd++;
+            }
+            ClosePendingStart();
+            if (pendingSpace && !contentStart) {
+                buffer += ' ';
+            }
+            pendingSpace = false;
+            AppendEscaped(data.substr(index, wordEnd - index));
+            contentStart = false;
+            started = true;
+            index = wordEnd;
+        }
+    }
+
+    // Writes the buffer to the sink, a held back '>' stays pending
+    bool WriteBuffer() {
+        if (buffer.empty()) {
+            return true;
+        }
+        bool result = sink->WriteBlock(buffer.data(), buffer.size());
+        buffer.clear();
+        return result;
+    }
+
+    bool Flush() {
+        ClosePendingStart();
+        return WriteBuffer();
     }
 };
 
-CXMLWriter::CXMLWriter(std::shared_ptr<CDataSink> sink)
-    : DImplementation(std::make_unique<SImplementation>(std::move(sink))) {}
+CXMLWriter::CXMLWriter(std::shared_ptr<CDataSink> sink, std::size_t flushthreshold, EFormat format, bool collapseempty)
+    : DImplementation(std::make_unique<SImplementation>(std::move(sink), flushthreshold, format, collapseempty)) {}
 
-CXMLWriter::~CXMLWriter() = default;
+CXMLWriter::~CXMLWriter() {
+    DImplementation->Flush();
+}
 
 bool CXMLWriter::Flush() {
-    return true; // No buffer to flush
+    bool result = DImplementation->Flush();
+    return DImplementation->sink->Flush() && result;
 }
 
 bool CXMLWriter::WriteEntity(const SXMLEntity& entity) {
@@ -79,7 +333,9 @@ bool CXMLWriter::WriteEntity(const SXMLEntity& entity) {
             DImplementation->StartElement(entity.DNameData, entity.DAttributes);
             break;
         case SXMLEntity::EType::EndElement:
-            DImplementation->EndElement(entity.DNameData);
+            if (!DImplementation->EndElement(entity.DNameData)) {
+                return false; // Does not match the open element
+            }
             break;
         case SXMLEntity::EType::CompleteElement:
             DImplementation->CompleteElement(entity.DNameData, entity.DAttributes);
@@ -90,5 +346,8 @@ bool CXMLWriter::WriteEntity(const SXMLEntity& entity) {
         default:
             return false; // Unknown entity type
     }
+    if (DImplementation->buffer.size() >= DImplementation->flushThreshold) {
+        return DImplementation->WriteBuffer();
+    }
     return true;
 }
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+#include "CompressedDataSource.h"
+#include "CompressedDataSink.h"
+#include "StringDataSource.h"
+#include "StringDataSink.h"
+#include "DSVReader.h"
+#include "DSVWriter.h"
+#include <memory>
+#include <string>
+#ifdef COMPRESSION_ZSTD
+#include <zstd.h>
+#endif
+
+static std::string TestData(){
+    std::string Data;
+    for(int Index = 0; Index < 20000; Index++){
+        Data += std::to_string(Index) + ",name " + std::to_string(Index * 7919 % 1000) + ",\"quoted, field\"\n";
+    }
+    return Data;
+}
+
+static std::string Compress(const std::string &data, ECompressionFormat format, std::size_t blocksize = 1024 * 1024){
+    auto Sink = std::make_shared<CStringDataSink>();
+    {
+        CCompressedDataSink Compressor(Sink, format, CompressionDefaultLevel, 0, blocksize);
+        
+        EXPECT_TRUE(Compressor.IsOpen());
+        // Mix small writes with blocks larger than the compressor's block size
+        std::size_t Offset = 0;
+        for(std::size_t Length = 1; Offset < data.size(); Length *= 3){
+            Length = std::min(Length, data.size() - Offset);
+            EXPECT_TRUE(Compressor.WriteBlock(data.data() + Offset, Length));
+            Offset += Length;
+        }
+        EXPECT_TRUE(Compressor.Finish());
+    }
+    return Sink->String();
+}
+
+static std::string Decompress(const std::string &data, ECompressionFormat format, bool background, bool &error){
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>(data), format, background, 4096);
+    std::string Result;
+    char Buffer[1000];
+    std::size_t Length;
+    
+    while((Length = Source.ReadBlock(Buffer, sizeof(Buffer)))){
+        Result.append(Buffer, Length);
+    }
+    EXPECT_TRUE(Source.End());
+    error = Source.Error();
+    return Result;
+}
+
+TEST(CompressionTest, GzipRoundTrip) {
+    std::string Data = TestData();
+    std::string Compressed = Compress(Data, ECompressionFormat::Gzip, 10000);
+    bool Error = true;
+    
+    EXPECT_LT(Compressed.size(), Data.size() / 3);
+    EXPECT_EQ(static_cast<unsigned char>(Compressed[0]), 0x1F);
+    EXPECT_EQ(Decompress(Compressed, ECompressionFormat::Gzip, true, Error), Data);
+    EXPECT_FALSE(Error);
+    EXPECT_EQ(Decompress(Compressed, ECompressionFormat::Auto, false, Error), Data);
+    EXPECT_FALSE(Error);
+}
+
+TEST(CompressionTest, ZlibRoundTrip) {
+    std::string Data = TestData();
+    bool Error = true;
+    
+    EXPECT_EQ(Decompress(Compress(Data, ECompressionFormat::Zlib), ECompressionFormat::Zlib, true, Error), Data);
+    EXPECT_FALSE(Error);
+}
+
+TEST(CompressionTest, ZstdRoundTrip) {
+    if(!CompressionFormatSupported(ECompressionFormat::Zstd)){
+        CCompressedDataSink Compressor(std::make_shared<CStringDataSink>(), ECompressionFormat::Zstd);
+        
+        EXPECT_FALSE(Compressor.IsOpen());
+        EXPECT_FALSE(Compressor.WriteBlock("data", 4));
+        GTEST_SKIP() << "zstd headers not available";
+    }
+    std::string Data = TestData();
+    bool Error = true;
+    
+    EXPECT_EQ(Decompress(Compress(Data, ECompressionFormat::Zstd), ECompressionFormat::Auto, true, Error), Data);
+    EXPECT_FALSE(Error);
+}
+
+TEST(CompressionTest, ZstdLevelsAndWindowLimit) {
+#ifdef COMPRESSION_ZSTD
+    std::string Data = TestData();
+    bool Error = true;
+    auto Sink = std::make_shared<CStringDataSink>();
+    {
+        // Negative levels are zstd's fast levels, not the default
+        CCompressedDataSink Compressor(Sink, ECompressionFormat::Zstd, -5, 30);
+        
+        EXPECT_TRUE(Compressor.WriteBlock(Data.data(), Data.size()));
+    }
+    EXPECT_EQ(Decompress(Sink->String(), ECompressionFormat::Auto, false, Error), Data);
+    EXPECT_FALSE(Error);
+    
+    // A frame that declares a window over the limit is rejected
+    ZSTD_CCtx *Context = ZSTD_createCCtx();
+    ZSTD_CCtx_setParameter(Context, ZSTD_c_windowLog, CompressionZstdMaxWindowLog + 1);
+    std::string Frame(ZSTD_compressBound(Data.size()) + 1024, '\0');
+    ZSTD_inBuffer Input = {Data.data(), Data.size(), 0};
+    ZSTD_outBuffer Output = {Frame.data(), Frame.size(), 0};
+    // Continuing before ending leaves the size unknown, so the window is kept
+    ZSTD_compressStream2(Context, &Output, &Input, ZSTD_e_continue);
+    EXPECT_EQ(ZSTD_compressStream2(Context, &Output, &Input, ZSTD_e_end), 0u);
+    ZSTD_freeCCtx(Context);
+    Frame.resize(Output.pos);
+    Error = false;
+    EXPECT_EQ(Decompress(Frame, ECompressionFormat::Zstd, true, Error), "");
+    EXPECT_TRUE(Error);
+#else
+    GTEST_SKIP() << "zstd headers not available";
+#endif
+}
+
+TEST(CompressionTest, ConcatenatedMembers) {
+    std::string First = "first part\n", Second = "second part\n";
+    bool Error = true;
+    
+    EXPECT_EQ(Decompress(Compress(First, ECompressionFormat::Gzip) + Compress(Second, ECompressionFormat::Gzip), ECompressionFormat::Auto, true, Error), First + Second);
+    EXPECT_FALSE(Error);
+}
+
+TEST(CompressionTest, UncompressedPassThrough) {
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>("plain,text\n"));
+    std::vector<char> Buffer;
+    
+    EXPECT_EQ(Source.Format(), ECompressionFormat::None);
+    EXPECT_TRUE(Source.Read(Buffer, 100));
+    EXPECT_EQ(std::string(Buffer.begin(), Buffer.end()), "plain,text\n");
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Error());
+}
+
+TEST(CompressionTest, TruncatedAndCorruptInput) {
+    std::string Data = TestData();
+    std::string Compressed = Compress(Data, ECompressionFormat::Gzip);
+    bool Error = false;
+    
+    std::string Partial = Decompress(Compressed.substr(0, Compressed.size() / 2), ECompressionFormat::Auto, true, Error);
+    EXPECT_TRUE(Error);
+    EXPECT_EQ(Partial, Data.substr(0, Partial.size()));
+    Compressed[Compressed.size() / 2] ^= 0x55;
+    Compressed[Compressed.size() / 2 + 1] ^= 0x55;
+    Decompress(Compressed, ECompressionFormat::Gzip, false, Error);
+    EXPECT_TRUE(Error);
+}
+
+TEST(CompressionTest, DSVOverCompressedData) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    {
+        auto Compressor = std::make_shared<CCompressedDataSink>(Sink, ECompressionFormat::Gzip, 9);
+        CDSVWriter Writer(Compressor, ',', false, 65536);
+        
+        for(int Index = 0; Index < 1000; Index++){
+            EXPECT_TRUE(Writer.WriteRow({std::to_string(Index), "a,b", "c"}));
+        }
+        EXPECT_TRUE(Writer.Flush());
+        EXPECT_FALSE(Sink->String().empty());
+    }
+    CDSVReader Reader(std::make_shared<CCompressedDataSource>(std::make_shared<CStringDataSource>(Sink->String())), ',');
+    std::vector<std::string> Row;
+    
+    for(int Index = 0; Index < 1000; Index++){
+        ASSERT_TRUE(Reader.ReadRow(Row));
+        ASSERT_EQ(Row.size(), 3);
+        EXPECT_EQ(Row[0], std::to_string(Index));
+        EXPECT_EQ(Row[1], "a,b");
+    }
+    EXPECT_FALSE(Reader.ReadRow(Row));
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(CompressionTest, EarlyDestruction) {
+    std::string Compressed = Compress(TestData(), ECompressionFormat::Gzip);
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>(Compressed), ECompressionFormat::Auto, true, 1024);
+    char Ch;
+    
+    // The background thread is stopped while it is blocked on a full queue
+    EXPECT_TRUE(Source.Get(Ch));
+    EXPECT_EQ(Ch, '0');
+}
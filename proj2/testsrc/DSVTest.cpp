@@ -3,6 +3,11 @@
 #include "DSVWriter.h"
 #include "StringDataSource.h"
 #include "StringDataSink.h"
+#include "DSVScanner.h"
+#include "ParallelDSVReader.h"
+#include <map>
+#include <mutex>
+#include <random>
 
 TEST(DSVWriter, EmptyRow) {
     auto sink = std::make_shared<CStringDataSink>();
@@ -57,6 +62,23 @@ TEST(DSVWriter, QuoteAllMode) {
     EXPECT_TRUE(writer.WriteRow(row));
     EXPECT_EQ(sink->String(), "\"a\",\"b\",\"c\"\n");
 }
+TEST(DSVWriter, BufferedRows) {
+    auto sink = std::make_shared<CStringDataSink>();
+    {
+        CDSVWriter writer(sink, ',', false, 16);
+        
+        EXPECT_TRUE(writer.WriteRow({"a", "b"}));
+        EXPECT_EQ(sink->String(), "");
+        EXPECT_TRUE(writer.WriteRow({"quote\"d", "c"}));
+        EXPECT_EQ(sink->String(), "a,b\n\"quote\"\"d\",c\n");
+        EXPECT_TRUE(writer.WriteRow({"d"}));
+        EXPECT_TRUE(writer.Flush());
+        EXPECT_EQ(sink->String(), "a,b\n\"quote\"\"d\",c\nd\n");
+        EXPECT_TRUE(writer.WriteRow({"e"}));
+    }
+    EXPECT_EQ(sink->String(), "a,b\n\"quote\"\"d\",c\nd\ne\n");
+}
+
 TEST(DSVReader, EmptySource) {
     auto source = std::make_shared<CStringDataSource>("");
     CDSVReader reader(source, ',');
@@ -123,3 +145,336 @@ TEST(DSVReader, MultipleRows) {
     
     EXPECT_TRUE(reader.End());
 }
+
+TEST(DSVReader, QuotedNewline) {
+    auto source = std::make_shared<CStringDataSource>("\"a\nb\",c\nd\n");
+    CDSVReader reader(source, ',');
+    std::vector<std::string> row;
+    
+    EXPECT_TRUE(reader.ReadRow(row));
+    EXPECT_EQ(row, std::vector<std::string>({"a\nb", "c"}));
+    EXPECT_TRUE(reader.ReadRow(row));
+    EXPECT_EQ(row, std::vector<std::string>({"d"}));
+    EXPECT_TRUE(reader.End());
+}
+
+TEST(DSVReader, StrayQuotes) {
+    auto source = std::make_shared<CStringDataSource>("a\"b,c\n\"ab\"cd,e\nx,y\"\"z\n\"\"\n\"\",\n");
+    CDSVReader reader(source, ',');
+    std::vector<std::string> row;
+    
+    // Quotes after the start of a field are ordinary characters
+    EXPECT_TRUE(reader.ReadRow(row));
+    EXPECT_EQ(row, std::vector<std::string>({"a\"b", "c"}));
+    EXPECT_TRUE(reader.ReadRow(row));
+    EXPECT_EQ(row, std::vector<std::string>({"abcd", "e"}));
+    EXPECT_TRUE(reader.ReadRow(row));
+    EXPECT_EQ(row, std::vector<std::string>({"x", "y\"\"z"}));
+    // A single empty field reads like an empty line
+    EXPECT_FALSE(reader.ReadRow(row));
+    EXPECT_TRUE(row.empty());
+    EXPECT_TRUE(reader.ReadRow(row));
+    EXPECT_EQ(row, std::vector<std::string>({"", ""}));
+    EXPECT_TRUE(reader.End());
+}
+
+TEST(DSVReader, UnbalancedQuote) {
+    std::string tail;
+    for (int index = 0; index < 10000; index++) {
+        tail += "row" + std::to_string(index) + ",x\n";
+    }
+    auto source = std::make_shared<CStringDataSource>("a,\"open\nb,c\n" + tail);
+    CDSVReader reader(source, ',', 1000);
+    std::vector<std::string> row;
+    
+    // Past the limit the next newline ends the row with the open quote
+    EXPECT_TRUE(reader.ReadRow(row));
+    ASSERT_EQ(row.size(), 2);
+    EXPECT_EQ(row[0], "a");
+    EXPECT_EQ(row[1].substr(0, 9), "open\nb,c\n");
+    EXPECT_GE(row[1].size(), 990);
+    EXPECT_LT(row[1].size(), 1010);
+    int next = std::stoi(row[1].substr(row[1].rfind("\nrow") + 4)) + 1;
+    for (int index = next; index < 10000; index++) {
+        ASSERT_TRUE(reader.ReadRow(row));
+        EXPECT_EQ(row, std::vector<std::string>({"row" + std::to_string(index), "x"}));
+    }
+    EXPECT_TRUE(reader.End());
+
+    CDSVReader unlimited(std::make_shared<CStringDataSource>("a,\"open\nb,c\n"), ',');
+    EXPECT_TRUE(unlimited.ReadRow(row));
+    EXPECT_EQ(row, std::vector<std::string>({"a", "open\nb,c\n"}));
+    EXPECT_TRUE(unlimited.End());
+}
+
+TEST(DSVReader, RowLargerThanBuffer) {
+    std::string longField(200000, 'x');
+    auto source = std::make_shared<CStringDataSource>(longField + ",\"" + longField + "\"\nend");
+    CDSVReader reader(source, ',');
+    std::vector<std::string> row;
+    
+    EXPECT_TRUE(reader.ReadRow(row));
+    ASSERT_EQ(row.size(), 2);
+    EXPECT_EQ(row[0], longField);
+    EXPECT_EQ(row[1], longField);
+    EXPECT_TRUE(reader.ReadRow(row));
+    EXPECT_EQ(row, std::vector<std::string>({"end"}));
+    EXPECT_TRUE(reader.End());
+}
+
+TEST(DSVRoundTrip, WriterOutputReadsBack) {
+    auto sink = std::make_shared<CStringDataSink>();
+    CDSVWriter writer(sink, '\t');
+    std::vector<std::string> original = {"plain", "tab\there", "quote\"d", "multi\nline", ""};
+    
+    EXPECT_TRUE(writer.WriteRow(original));
+    auto source = std::make_shared<CStringDataSource>(sink->String());
+    CDSVReader reader(source, '\t');
+    std::vector<std::string> row;
+    EXPECT_TRUE(reader.ReadRow(row));
+    EXPECT_EQ(row, original);
+    EXPECT_TRUE(reader.End());
+}
+
+TEST(DSVReader, ReadRowView) {
+    auto source = std::make_shared<CStringDataSource>("a,\"b,\"\"c\"\"\",\nlast\n");
+    CDSVReader reader(source, ',');
+    std::vector<std::string_view> row;
+    
+    EXPECT_TRUE(reader.ReadRowView(row));
+    ASSERT_EQ(row.size(), 3);
+    EXPECT_EQ(row[0], "a");
+    EXPECT_EQ(row[1], "b,\"c\"");
+    EXPECT_EQ(row[2], "");
+    EXPECT_TRUE(reader.ReadRowView(row));
+    ASSERT_EQ(row.size(), 1);
+    EXPECT_EQ(row[0], "last");
+    EXPECT_TRUE(reader.End());
+    EXPECT_FALSE(reader.ReadRowView(row));
+    EXPECT_TRUE(row.empty());
+}
+
+TEST(DSVScanner, ClassifyMasks) {
+    std::string block = "a,\"b\"\nc";
+    auto masks = DSVScanner::Classify(block.data(), block.size(), ',');
+    
+    EXPECT_EQ(masks.DQuote, 0x14);
+    EXPECT_EQ(masks.DDelimiter, 0x02);
+    EXPECT_EQ(masks.DNewline, 0x20);
+}
+
+TEST(DSVScanner, ImplementationsMatchReference) {
+    std::mt19937 generator(34);
+    const char alphabet[] = "ab,\"\n";
+    std::string input;
+    for (int index = 0; index < 5000; index++) {
+        input += alphabet[generator() % 5];
+    }
+    // Reference row ends and delimiters computed one character at a time
+    std::vector<std::size_t> expectedEnds, expectedDelimiters;
+    bool inQuotes = false;
+    std::size_t fieldStart = 0;
+    for (std::size_t index = 0; index < input.size(); index++) {
+        if (inQuotes) {
+            if (input[index] == '"' && index + 1 < input.size()) {
+                if (input[index + 1] == '"') {
+                    index++;
+                }
+                else {
+                    inQuotes = false;
+                }
+            }
+        }
+        else if (input[index] == '"') {
+            inQuotes = index == fieldStart;
+        }
+        else if (input[index] == '\n') {
+            expectedEnds.push_back(index);
+            fieldStart = index + 1;
+        }
+        else if (input[index] == ',') {
+            expectedDelimiters.push_back(index);
+            fieldStart = index + 1;
+        }
+    }
+    auto original = DSVScanner::ActiveImplementation();
+    for (auto implementation : {DSVScanner::EImplementation::Scalar, DSVScanner::EImplementation::SSE2, DSVScanner::EImplementation::AVX2}) {
+        if (!DSVScanner::SelectImplementation(implementation)) {
+            continue;
+        }
+        std::vector<std::size_t> ends, delimiters;
+        DSVScanner::SScanState state;
+        std::size_t offset = 0;
+        while (true) {
+            // Resume in uneven slices to exercise the partial blocks
+            std::size_t length = std::min(input.size(), offset + 77);
+            offset = DSVScanner::FindRowEnd(input.data(), offset, length, ',', state, delimiters);
+            if (offset < length) {
+                ends.push_back(offset++);
+            }
+            else if (length == input.size()) {
+                break;
+            }
+        }
+        EXPECT_EQ(ends, expectedEnds);
+        EXPECT_EQ(delimiters, expectedDelimiters);
+        EXPECT_EQ(state.DInQuotes, inQuotes);
+    }
+    DSVScanner::SelectImplementation(original);
+}
+
+static std::string ParallelTestInput() {
+    std::string input;
+    for (int index = 0; index < 500; index++) {
+        input += std::to_string(index) + ",\"multi\nline " + std::to_string(index) + "\",\"say \"\"hi\"\"\"\n";
+        if (index % 50 == 0) {
+            // Rows much longer than a chunk
+            input += std::string(300, 'x') + "," + std::string(300, 'y') + "\n\n";
+        }
+    }
+    return input;
+}
+
+// Every row as returned by ReadRow, empty lines read as empty rows
+static std::vector<std::vector<std::string>> SerialRows(const std::string &input, std::size_t maxrowsize = SIZE_MAX) {
+    CDSVReader reader(std::make_shared<CStringDataSource>(input), ',', maxrowsize);
+    std::vector<std::vector<std::string>> rows;
+    std::vector<std::string> row;
+    while (!reader.End()) {
+        bool result = reader.ReadRow(row);
+        EXPECT_EQ(result, !row.empty());
+        rows.push_back(row);
+    }
+    return rows;
+}
+
+static std::vector<std::vector<std::string>> ParallelRows(CParallelDSVReader &reader) {
+    std::vector<std::vector<std::string>> rows;
+    std::vector<std::string> row;
+    while (!reader.End()) {
+        bool result = reader.ReadRow(row);
+        EXPECT_EQ(result, !row.empty());
+        rows.push_back(row);
+    }
+    EXPECT_FALSE(reader.ReadRow(row));
+    return rows;
+}
+
+TEST(ParallelDSVReader, MatchesSerialReader) {
+    std::string input = ParallelTestInput();
+    auto expected = SerialRows(input);
+    CParallelDSVReader reader(std::make_shared<CStringDataSource>(input), ',', 4, 64);
+    
+    EXPECT_EQ(expected.size(), 520);
+    EXPECT_EQ(ParallelRows(reader), expected);
+    EXPECT_TRUE(reader.End());
+}
+
+TEST(ParallelDSVReader, StrayAndUnbalancedQuotes) {
+    std::string input;
+    for (int index = 0; index < 300; index++) {
+        input += "a\"" + std::to_string(index) + ",\"b\"c,\"\"\n\n";
+        if (index % 100 == 7) {
+            // Never closed, only the row size limit ends it
+            input += "x,\"open\n";
+        }
+    }
+    for (std::size_t chunksize : {16, 100, 4096}) {
+        auto expected = SerialRows(input, 500);
+        CParallelDSVReader reader(std::make_shared<CStringDataSource>(input), ',', 3, chunksize, 500);
+        
+        EXPECT_EQ(ParallelRows(reader), expected);
+        ASSERT_GT(expected.size(), 3);
+        EXPECT_EQ(expected[0], std::vector<std::string>({"a\"0", "bc", ""}));
+    }
+}
+
+TEST(ParallelDSVReader, LongQuotedFieldUnlimited) {
+    // A valid quoted field with newlines, larger than the initial buffers
+    std::string field;
+    for (int index = 0; index < 20000; index++) {
+        field += "line " + std::to_string(index) + "\n";
+    }
+    std::string input = "a,\"" + field + "\",b\nc\n";
+    auto expected = std::vector<std::vector<std::string>>({{"a", field, "b"}, {"c"}});
+    CParallelDSVReader reader(std::make_shared<CStringDataSource>(input), ',', 2, 4096);
+    
+    EXPECT_EQ(SerialRows(input), expected);
+    EXPECT_EQ(ParallelRows(reader), expected);
+}
+
+TEST(ParallelDSVReader, ChunkCallback) {
+    std::string input = ParallelTestInput();
+    auto expected = SerialRows(input);
+    CParallelDSVReader reader(std::make_shared<CStringDataSource>(input), ',', 3, 1000);
+    std::map<std::size_t, std::vector<std::vector<std::string>>> chunks;
+    std::mutex chunksMutex;
+    
+    EXPECT_TRUE(reader.ReadChunks([&](std::size_t index, std::vector<std::vector<std::string>> &rows) {
+        std::lock_guard<std::mutex> lock(chunksMutex);
+        EXPECT_EQ(chunks.count(index), 0);
+        chunks[index] = std::move(rows);
+    }));
+    std::vector<std::vector<std::string>> rows;
+    for (auto &chunk : chunks) {
+        rows.insert(rows.end(), chunk.second.begin(), chunk.second.end());
+    }
+    EXPECT_EQ(rows, expected);
+    EXPECT_TRUE(reader.End());
+}
+
+TEST(DSVReader, ReadBatch) {
+    auto source = std::make_shared<CStringDataSource>("a,1\nb,2,x\n\nc\n\"d,\"\"\",4\n");
+    CDSVReader reader(source, ',');
+    CColumnBatch batch;
+    
+    EXPECT_TRUE(reader.ReadBatch(3, batch));
+    EXPECT_EQ(batch.RowCount(), 3);
+    ASSERT_EQ(batch.ColumnCount(), 3);
+    EXPECT_EQ(batch.Value(0, 0), "a");
+    EXPECT_EQ(batch.Value(0, 1), "b");
+    EXPECT_EQ(batch.Value(0, 2), "c");
+    EXPECT_EQ(batch.Value(1, 0), "1");
+    EXPECT_EQ(batch.Value(1, 2), "");
+    EXPECT_EQ(batch.Value(2, 0), "");
+    EXPECT_EQ(batch.Value(2, 1), "x");
+    EXPECT_EQ(batch.Column(1).DOffsets, std::vector<std::size_t>({0, 1, 2, 2}));
+    
+    EXPECT_TRUE(reader.ReadBatch(3, batch));
+    EXPECT_EQ(batch.RowCount(), 1);
+    ASSERT_EQ(batch.ColumnCount(), 2);
+    EXPECT_EQ(batch.Value(0, 0), "d,\"");
+    EXPECT_EQ(batch.Value(1, 0), "4");
+    EXPECT_FALSE(reader.ReadBatch(3, batch));
+    EXPECT_EQ(batch.RowCount(), 0);
+}
+
+TEST(DSVReader, ReadTypedRow) {
+    auto source = std::make_shared<CStringDataSource>("42,skip,\"3.5\",true,name\n-7,,x,0\n\n");
+    CDSVReader reader(source, ',');
+    using EColumnType = CDSVReader::EColumnType;
+    std::vector<CDSVReader::STypedField> row;
+    
+    reader.SetSchema({EColumnType::Int64, EColumnType::Skip, EColumnType::Double, EColumnType::Bool, EColumnType::String});
+    EXPECT_TRUE(reader.ReadTypedRow(row));
+    ASSERT_EQ(row.size(), 4);
+    EXPECT_TRUE(row[0].DValid);
+    EXPECT_EQ(row[0].DInt64, 42);
+    EXPECT_TRUE(row[1].DValid);
+    EXPECT_DOUBLE_EQ(row[1].DDouble, 3.5);
+    EXPECT_TRUE(row[2].DValid);
+    EXPECT_TRUE(row[2].DBool);
+    EXPECT_TRUE(row[3].DValid);
+    EXPECT_EQ(row[3].DString, "name");
+    
+    EXPECT_TRUE(reader.ReadTypedRow(row));
+    ASSERT_EQ(row.size(), 4);
+    EXPECT_EQ(row[0].DInt64, -7);
+    EXPECT_FALSE(row[1].DValid);
+    EXPECT_TRUE(row[2].DValid);
+    EXPECT_FALSE(row[2].DBool);
+    EXPECT_FALSE(row[3].DValid);
+    
+    EXPECT_FALSE(reader.ReadTypedRow(row));
+    EXPECT_TRUE(reader.End());
+}
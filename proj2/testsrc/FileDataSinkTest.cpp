@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include "FileDataSink.h"
+#include "DSVWriter.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+static std::string TempFileName(){
+    char FileName[] = "/tmp/filedatasinkXXXXXX";
+    int FileDescriptor = mkstemp(FileName);
+    if(FileDescriptor >= 0){
+        close(FileDescriptor);
+    }
+    return FileName;
+}
+
+static std::string FileContents(const std::string &filename){
+    std::ifstream Input(filename, std::ios::binary);
+    std::stringstream Contents;
+    Contents << Input.rdbuf();
+    return Contents.str();
+}
+
+TEST(FileDataSink, MissingDirectoryTest){
+    CFileDataSink Sink("/tmp/this/directory/does/not/exist");
+
+    EXPECT_FALSE(Sink.IsOpen());
+    EXPECT_FALSE(Sink.Put('x'));
+    EXPECT_FALSE(Sink.WriteBlock("abc",3));
+    EXPECT_FALSE(Sink.Flush());
+}
+
+TEST(FileDataSink, PutWriteTest){
+    std::string FileName = TempFileName();
+    {
+        CFileDataSink Sink(FileName);
+        std::vector<char> TempVector = {' ','W','o','r','l','d'};
+
+        EXPECT_TRUE(Sink.IsOpen());
+        EXPECT_TRUE(Sink.Put('H'));
+        EXPECT_TRUE(Sink.WriteBlock("ello",4));
+        EXPECT_TRUE(Sink.Write(TempVector));
+        EXPECT_EQ(Sink.BytesWritten(),0);
+        EXPECT_TRUE(Sink.Flush());
+        EXPECT_EQ(Sink.BytesWritten(),11);
+        EXPECT_EQ(FileContents(FileName),"Hello World");
+        EXPECT_TRUE(Sink.Put('!'));
+    }
+    EXPECT_EQ(FileContents(FileName),"Hello World!");
+    unlink(FileName.c_str());
+}
+
+TEST(FileDataSink, LargeBlocksTest){
+    std::string FileName = TempFileName();
+    std::string Expected;
+    {
+        CFileDataSink Sink(FileName, false, CFileDataSink::ESyncPolicy::OnClose, 4096);
+
+        for(int Index = 0; Index < 20; Index++){
+            // Blocks larger than the buffer skip it, smaller ones fill it
+            std::string Block(Index % 2 ? 10000 : 1000, char('a' + Index));
+            EXPECT_TRUE(Sink.WriteBlock(Block.data(), Block.size()));
+            Expected += Block;
+        }
+        EXPECT_GE(Sink.BytesWritten(), 100000);
+    }
+    EXPECT_EQ(FileContents(FileName),Expected);
+    unlink(FileName.c_str());
+}
+
+TEST(FileDataSink, DirectIOTest){
+    std::string FileName = TempFileName();
+    std::string Expected;
+    {
+        // Falls back to buffered writes where O_DIRECT is not supported
+        CFileDataSink Sink(FileName, true, CFileDataSink::ESyncPolicy::OnFlush, 8192);
+
+        EXPECT_TRUE(Sink.IsOpen());
+        for(int Index = 0; Index < 1000; Index++){
+            std::string Line = "line " + std::to_string(Index) + "\n";
+            EXPECT_TRUE(Sink.WriteBlock(Line.data(), Line.size()));
+            Expected += Line;
+        }
+        EXPECT_TRUE(Sink.Flush());
+        EXPECT_FALSE(Sink.IsDirect());
+        EXPECT_EQ(Sink.BytesWritten(), Expected.size());
+    }
+    EXPECT_EQ(FileContents(FileName),Expected);
+    unlink(FileName.c_str());
+}
+
+TEST(FileDataSink, DSVWriterTest){
+    std::string FileName = TempFileName();
+    auto Sink = std::make_shared<CFileDataSink>(FileName);
+    CDSVWriter Writer(Sink, ',', false, 4096);
+
+    EXPECT_TRUE(Writer.WriteRow({"a","b,c"}));
+    EXPECT_TRUE(Writer.WriteRow({"1","2"}));
+    EXPECT_EQ(FileContents(FileName),"");
+    EXPECT_TRUE(Writer.Flush());
+    EXPECT_EQ(FileContents(FileName),"a,\"b,c\"\n1,2\n");
+    unlink(FileName.c_str());
+}
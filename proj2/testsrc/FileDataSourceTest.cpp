@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "FileDataSource.h"
+#include "DSVReader.h"
+#include <cstdlib>
+#include <unistd.h>
+
+static std::string CreateTempFile(const std::string &contents){
+    char FileName[] = "/tmp/filedatasourceXXXXXX";
+    int FileDescriptor = mkstemp(FileName);
+    if(FileDescriptor >= 0){
+        if(write(FileDescriptor, contents.data(), contents.size()) != ssize_t(contents.size())){
+            ADD_FAILURE() << "Failed to write " << FileName;
+        }
+        close(FileDescriptor);
+    }
+    return FileName;
+}
+
+TEST(FileDataSource, MissingFileTest){
+    CFileDataSource Source("/tmp/this/file/does/not/exist");
+    char TempCh = 'x';
+
+    EXPECT_FALSE(Source.IsOpen());
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'x');
+}
+
+TEST(FileDataSource, EmptyFileTest){
+    std::string FileName = CreateTempFile("");
+    CFileDataSource Source(FileName);
+    std::vector< char > TempVector;
+
+    EXPECT_TRUE(Source.IsOpen());
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Read(TempVector,3));
+    unlink(FileName.c_str());
+}
+
+TEST(FileDataSource, MappedGetPeekReadTest){
+    std::string FileName = CreateTempFile("Hello World");
+    CFileDataSource Source(FileName);
+    std::vector< char > TempVector;
+    char TempCh = 'x';
+
+    EXPECT_TRUE(Source.IsMapped());
+    EXPECT_FALSE(Source.End());
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Read(TempVector,4));
+    EXPECT_EQ(std::string(TempVector.begin(),TempVector.end()),"ello");
+    EXPECT_TRUE(Source.Read(TempVector,100));
+    EXPECT_EQ(std::string(TempVector.begin(),TempVector.end())," World");
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Peek(TempCh));
+    unlink(FileName.c_str());
+}
+
+TEST(FileDataSource, PipeFallbackTest){
+    int Pipe[2];
+    ASSERT_EQ(pipe(Pipe),0);
+    std::string Contents = "a,b\nc,d\n";
+    ASSERT_EQ(write(Pipe[1], Contents.data(), Contents.size()),ssize_t(Contents.size()));
+    close(Pipe[1]);
+    {
+        auto Source = std::make_shared<CFileDataSource>(Pipe[0]);
+        CDSVReader Reader(Source, ',');
+        std::vector< std::string > Row;
+
+        EXPECT_FALSE(Source->IsMapped());
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row, std::vector< std::string >({"a","b"}));
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row, std::vector< std::string >({"c","d"}));
+        EXPECT_TRUE(Reader.End());
+    }
+    close(Pipe[0]);
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include "PrefetchDataSource.h"
+#include "StringDataSource.h"
+#include "DSVReader.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Hands out its data a few bytes at a time and counts how much was read
+class CCountingDataSource : public CDataSource{
+    private:
+        std::string DData;
+        std::size_t DIndex = 0;
+    public:
+        std::atomic< std::size_t > DBytesRead{0};
+
+        CCountingDataSource(const std::string &data) : DData(data){}
+        bool End() const noexcept override{
+            return DIndex >= DData.size();
+        }
+        bool Get(char &ch) noexcept override{
+            return ReadBlock(&ch, 1) == 1;
+        }
+        bool Peek(char &) noexcept override{
+            return false;
+        }
+        bool Read(std::vector<char> &, std::size_t) noexcept override{
+            return false;
+        }
+        std::size_t ReadBlock(char *buf, std::size_t count) noexcept override{
+            std::size_t Length = std::min({count, DData.size() - DIndex, std::size_t(7)});
+            DData.copy(buf, Length, DIndex);
+            DIndex += Length;
+            DBytesRead += Length;
+            return Length;
+        }
+};
+
+// The alphabet repeated, its period does not divide the slot sizes used so
+// slots that are read out of order show up in the result
+static std::string AlphabetData(std::size_t size){
+    std::string Data(size, ' ');
+    for(std::size_t Index = 0; Index < size; Index++){
+        Data[Index] = char('a' + Index % 26);
+    }
+    return Data;
+}
+
+TEST(PrefetchDataSource, EmptySourceTest){
+    CPrefetchDataSource Source(std::make_shared<CStringDataSource>(""));
+    std::vector< char > Buffer;
+    char TempCh = 'x';
+
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_FALSE(Source.Peek(TempCh));
+    EXPECT_FALSE(Source.Read(Buffer, 3));
+    EXPECT_EQ(TempCh, 'x');
+}
+
+TEST(PrefetchDataSource, GetPeekReadTest){
+    CPrefetchDataSource Source(std::make_shared<CStringDataSource>("Hello World"), 4, 2);
+    std::vector< char > Buffer;
+    char TempCh;
+
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh, 'H');
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh, 'H');
+    EXPECT_TRUE(Source.Read(Buffer, 6));
+    EXPECT_EQ(std::string(Buffer.begin(), Buffer.end()), "ello W");
+    EXPECT_TRUE(Source.Read(Buffer, 100));
+    EXPECT_EQ(std::string(Buffer.begin(), Buffer.end()), "orld");
+    EXPECT_TRUE(Source.End());
+}
+
+TEST(PrefetchDataSource, ReadAheadIsBoundedTest){
+    std::string Data = AlphabetData(3000);
+    auto Counting = std::make_shared<CCountingDataSource>(Data);
+    CPrefetchDataSource Source(Counting, 100, 3);
+    char TempCh;
+
+    EXPECT_TRUE(Source.Get(TempCh));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    // The slot being read plus the two others in the ring
+    EXPECT_LE(Counting->DBytesRead, 300);
+    std::string Result(1, TempCh);
+    std::vector< char > Buffer;
+    while(Source.Read(Buffer, 333)){
+        Result.append(Buffer.begin(), Buffer.end());
+    }
+    EXPECT_EQ(Result, Data);
+    EXPECT_TRUE(Source.End());
+}
+
+TEST(PrefetchDataSource, DSVReaderTest){
+    // Quoted delimiters fall on slot boundaries as the rows grow longer
+    std::string Data;
+    for(int Index = 0; Index < 500; Index++){
+        Data += std::to_string(Index) + ",\"a,b\",c\n";
+    }
+    CDSVReader Reader(std::make_shared<CPrefetchDataSource>(std::make_shared<CCountingDataSource>(Data), 64), ',');
+    std::vector< std::string > Row;
+
+    for(int Index = 0; Index < 500; Index++){
+        ASSERT_TRUE(Reader.ReadRow(Row));
+        ASSERT_EQ(Row.size(), 3);
+        EXPECT_EQ(Row[0], std::to_string(Index));
+        EXPECT_EQ(Row[1], "a,b");
+    }
+    EXPECT_FALSE(Reader.ReadRow(Row));
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(PrefetchDataSource, EarlyDestructionTest){
+    // The background thread is blocked on a full ring when the source goes away
+    for(int Index = 0; Index < 20; Index++){
+        CPrefetchDataSource Source(std::make_shared<CStringDataSource>(AlphabetData(1000)), 16, 2);
+        char TempCh;
+
+        EXPECT_TRUE(Source.Get(TempCh));
+        EXPECT_EQ(TempCh, 'a');
+    }
+}
@@ -30,3 +30,78 @@ TEST(StringDataSink, WriteTest){
     EXPECT_TRUE(Sink.Write(TempVector2));
     EXPECT_EQ(Sink.String(),"Hello World");   
 }
+
+TEST(StringDataSink, WriteBlockTest){
+    CStringDataSink Sink;
+
+    EXPECT_TRUE(Sink.WriteBlock("Hello",5));
+    EXPECT_TRUE(Sink.WriteBlock(" World!",6));
+    EXPECT_EQ(Sink.String(),"Hello World");
+}
+
+TEST(StringDataSink, LargeOutputTest){
+    CStringDataSink Sink;
+    std::string Expected;
+
+    for(int Index = 0; Index < 5000; Index++){
+        std::string Block(Index % 50, char('a' + Index % 26));
+        EXPECT_TRUE(Sink.WriteBlock(Block.data(), Block.size()));
+        EXPECT_TRUE(Sink.Put('\n'));
+        Expected += Block + "\n";
+    }
+    EXPECT_EQ(Sink.Size(), Expected.size());
+    std::string Joined;
+    auto Vectors = Sink.IOVectors();
+    EXPECT_GT(Vectors.size(), 1);
+    for(auto &Vector : Vectors){
+        Joined.append(static_cast<const char *>(Vector.iov_base), Vector.iov_len);
+    }
+    EXPECT_EQ(Joined, Expected);
+    EXPECT_EQ(Sink.String(), Expected);
+    EXPECT_EQ(Sink.IOVectors().size(), 1);
+}
+
+TEST(StringDataSink, ReserveTest){
+    CStringDataSink Sink;
+
+    Sink.Reserve(100000);
+    for(int Index = 0; Index < 10000; Index++){
+        EXPECT_TRUE(Sink.WriteBlock("0123456789", 10));
+    }
+    EXPECT_EQ(Sink.IOVectors().size(), 1);
+    EXPECT_EQ(Sink.Size(), 100000);
+}
+
+TEST(StringDataSink, TakeTest){
+    CStringDataSink Sink;
+
+    EXPECT_TRUE(Sink.WriteBlock("Hello", 5));
+    EXPECT_EQ(Sink.Take(), "Hello");
+    EXPECT_EQ(Sink.Size(), 0);
+    EXPECT_EQ(Sink.String(), "");
+    EXPECT_TRUE(Sink.WriteBlock(" World", 6));
+    auto Chunks = Sink.TakeChunks();
+    ASSERT_EQ(Chunks.size(), 1);
+    EXPECT_EQ(Chunks[0], " World");
+    EXPECT_EQ(Sink.Take(), "");
+}
+
+TEST(StringDataSink, InterleavedStringTest){
+    CStringDataSink Sink;
+    std::string Block(100, 'x');
+    const char *Previous = nullptr;
+    int Moves = 0;
+
+    for(int Index = 0; Index < 20000; Index++){
+        EXPECT_TRUE(Sink.WriteBlock(Block.data(), Block.size()));
+        const std::string &Result = Sink.String();
+        ASSERT_EQ(Result.size(), (Index + 1) * Block.size());
+        if(Result.data() != Previous){
+            Previous = Result.data();
+            Moves++;
+        }
+    }
+    // Writes append to the combined string, it is only recopied as it grows
+    EXPECT_LT(Moves, 40);
+    EXPECT_EQ(Sink.String(), std::string(2000000, 'x'));
+}
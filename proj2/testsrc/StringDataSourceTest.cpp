@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "StringDataSource.h"
+#include "StringViewDataSource.h"
+#include <memory>
 
 TEST(StringDataSource, EndTest){
     CStringDataSource EmptySource("");
@@ -81,3 +83,74 @@ TEST(StringDataSource, ReadTest){
     EXPECT_FALSE(Source2.Peek(TempCh));
     EXPECT_EQ(TempCh,'x');
 }
+
+TEST(StringDataSource, ReadBlockTest){
+    CStringDataSource Source("Hello");
+    char Buffer[8];
+
+    EXPECT_EQ(Source.ReadBlock(Buffer,3),3);
+    EXPECT_EQ(std::string(Buffer,3),"Hel");
+    EXPECT_EQ(Source.ReadBlock(Buffer,8),2);
+    EXPECT_EQ(std::string(Buffer,2),"lo");
+    EXPECT_EQ(Source.ReadBlock(Buffer,8),0);
+    EXPECT_TRUE(Source.End());
+}
+
+TEST(StringDataSource, MoveConstructTest){
+    std::string Input(1000, 'x');
+    CStringDataSource Source(std::move(Input));
+    char Buffer[1000];
+
+    EXPECT_EQ(Source.ReadBlock(Buffer, sizeof(Buffer)), 1000);
+    EXPECT_EQ(std::string(Buffer, 1000), std::string(1000, 'x'));
+    EXPECT_TRUE(Source.End());
+}
+
+TEST(StringDataSource, CopyTest){
+    auto Original = std::make_unique<CStringDataSource>("Hello");
+    char ch;
+
+    EXPECT_TRUE(Original->Get(ch));
+    CStringDataSource Source(*Original);
+    Original.reset();
+    EXPECT_TRUE(Source.Get(ch));
+    EXPECT_EQ(ch, 'e');
+    CStringDataSource Other("abc");
+    Other = Source;
+    Source = CStringDataSource("xyz");
+    EXPECT_TRUE(Other.Get(ch));
+    EXPECT_EQ(ch, 'l');
+    EXPECT_TRUE(Source.Get(ch));
+    EXPECT_EQ(ch, 'x');
+}
+
+TEST(StringViewDataSource, GetPeekReadTest){
+    std::string Input = "Hello World";
+    CStringViewDataSource Source(Input);
+    std::vector<char> TempVector;
+    char TempCh = 'x';
+
+    EXPECT_FALSE(Source.End());
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Read(TempVector,4));
+    EXPECT_EQ(std::string(TempVector.begin(),TempVector.end()),"ello");
+    char Buffer[16];
+    EXPECT_EQ(Source.ReadBlock(Buffer,16),6);
+    EXPECT_EQ(std::string(Buffer,6)," World");
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_FALSE(Source.Read(TempVector,4));
+}
+
+TEST(StringViewDataSource, PointerLengthTest){
+    const char Input[] = "abc\0def";
+    CStringViewDataSource Source(Input, 7);
+    char Buffer[8];
+
+    EXPECT_EQ(Source.ReadBlock(Buffer,8),7);
+    EXPECT_EQ(std::string(Buffer,7),std::string(Input,7));
+    EXPECT_EQ(Source.ReadBlock(Buffer,8),0);
+}
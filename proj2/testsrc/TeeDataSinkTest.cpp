@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include "TeeDataSink.h"
+#include "StringDataSink.h"
+#include "CompressedDataSink.h"
+#include "CompressedDataSource.h"
+#include "StringDataSource.h"
+#include "DSVWriter.h"
+#include <atomic>
+
+// Accepts limit bytes and fails after that, counting flushes
+class CLimitedDataSink : public CDataSink{
+    private:
+        std::size_t DLimit;
+    public:
+        std::string DData;
+        std::atomic< int > DFlushes{0};
+
+        CLimitedDataSink(std::size_t limit) : DLimit(limit){}
+        bool Put(const char &ch) noexcept override{
+            return WriteBlock(&ch, 1);
+        }
+        bool Write(const std::vector<char> &buf) noexcept override{
+            return WriteBlock(buf.data(), buf.size());
+        }
+        bool WriteBlock(const char *buf, std::size_t count) noexcept override{
+            if(DData.size() + count > DLimit){
+                return false;
+            }
+            DData.append(buf, count);
+            return true;
+        }
+        bool Flush() noexcept override{
+            DFlushes++;
+            return true;
+        }
+};
+
+// Every byte position holds different text, so lost, repeated or reordered
+// blocks change the result
+static std::string NumberedData(){
+    std::string Data;
+    for(int Index = 0; Index < 8000; Index++){
+        Data += std::to_string(Index) + ' ';
+    }
+    return Data;
+}
+
+static void WriteInPieces(CDataSink &sink, const std::string &data){
+    std::size_t Offset = 0;
+    for(std::size_t Length = 1; Offset < data.size(); Length = Length * 2 + 1){
+        Length = std::min(Length, data.size() - Offset);
+        sink.WriteBlock(data.data() + Offset, Length);
+        Offset += Length;
+    }
+}
+
+TEST(TeeDataSink, NoChildrenTest){
+    CTeeDataSink Sink({});
+
+    EXPECT_EQ(Sink.ChildCount(), 0);
+    EXPECT_TRUE(Sink.Put('x'));
+    EXPECT_TRUE(Sink.Flush());
+    EXPECT_FALSE(Sink.ChildFailed(0));
+}
+
+TEST(TeeDataSink, FanOutTest){
+    std::string Data = NumberedData();
+    for(bool Threaded : {false, true}){
+        auto First = std::make_shared<CStringDataSink>();
+        auto Second = std::make_shared<CStringDataSink>();
+        {
+            CTeeDataSink Sink({First, Second}, Threaded, 1000, 2);
+
+            EXPECT_EQ(Sink.ChildCount(), 2);
+            EXPECT_TRUE(Sink.Put(Data[0]));
+            WriteInPieces(Sink, Data.substr(1));
+        }
+        EXPECT_EQ(First->String(), Data);
+        EXPECT_EQ(Second->String(), Data);
+    }
+}
+
+TEST(TeeDataSink, ChildFailureTest){
+    std::string Data = NumberedData();
+    for(bool Threaded : {false, true}){
+        auto Good = std::make_shared<CLimitedDataSink>(Data.size());
+        auto Bad = std::make_shared<CLimitedDataSink>(100);
+        CTeeDataSink Sink({Good, Bad}, Threaded, 64);
+
+        WriteInPieces(Sink, Data);
+        EXPECT_FALSE(Sink.Flush());
+        EXPECT_FALSE(Sink.ChildFailed(0));
+        EXPECT_TRUE(Sink.ChildFailed(1));
+        EXPECT_FALSE(Sink.ChildFailed(2));
+        EXPECT_EQ(Good->DData, Data);
+        EXPECT_LE(Bad->DData.size(), 100);
+        EXPECT_EQ(Good->DFlushes, 1);
+        EXPECT_EQ(Bad->DFlushes, 0);
+    }
+}
+
+TEST(TeeDataSink, FlushReachesChildrenTest){
+    auto Child = std::make_shared<CLimitedDataSink>(1000);
+    CTeeDataSink Sink({Child}, true, 1000);
+
+    EXPECT_TRUE(Sink.WriteBlock("abc", 3));
+    EXPECT_TRUE(Sink.Flush());
+    // Flush waits for the child thread to write and flush
+    EXPECT_EQ(Child->DData, "abc");
+    EXPECT_EQ(Child->DFlushes, 1);
+}
+
+TEST(TeeDataSink, DSVWriterToFileAndCompressorTest){
+    auto Plain = std::make_shared<CStringDataSink>();
+    auto Compressed = std::make_shared<CStringDataSink>();
+    {
+        auto Compressor = std::make_shared<CCompressedDataSink>(Compressed);
+        CDSVWriter Writer(std::make_shared<CTeeDataSink>(std::vector< std::shared_ptr< CDataSink > >{Plain, Compressor}, true), ',');
+
+        for(int Index = 0; Index < 1000; Index++){
+            EXPECT_TRUE(Writer.WriteRow({std::to_string(Index), "a,b"}));
+        }
+    }
+    CCompressedDataSource Source(std::make_shared<CStringDataSource>(Compressed->String()));
+    std::vector< char > Buffer;
+    std::string Result;
+
+    while(Source.Read(Buffer, 4096)){
+        Result.append(Buffer.begin(), Buffer.end());
+    }
+    EXPECT_EQ(Plain->String().substr(0, 12), "0,\"a,b\"\n1,\"a");
+    EXPECT_EQ(Result, Plain->String());
+}
@@ -1,11 +1,68 @@
 #include <gtest/gtest.h>
 #include "XMLReader.h"
+#include "XMLPathFilter.h"
+#include "XMLPathReader.h"
+#include "ParallelXMLReader.h"
 #include "XMLWriter.h"
 #include "StringDataSink.h"
 #include "StringDataSource.h"
 #include <memory>
 #include <string>
 
+TEST(XMLEntityTest, ManyAttributes) {
+    SXMLEntity Entity;
+    Entity.DType = SXMLEntity::EType::StartElement;
+    Entity.DNameData = "node";
+    
+    for(int Index = 0; Index < 60; Index++){
+        EXPECT_TRUE(Entity.SetAttribute("attr" + std::to_string(Index), std::to_string(Index)));
+    }
+    EXPECT_FALSE(Entity.SetAttribute("", "empty"));
+    EXPECT_TRUE(Entity.SetAttribute("attr7", "seven"));
+    ASSERT_EQ(Entity.DAttributes.size(), 60);
+    for(int Index = 0; Index < 60; Index++){
+        std::string Name = "attr" + std::to_string(Index);
+        EXPECT_TRUE(Entity.AttributeExists(Name));
+        EXPECT_EQ(Entity.DAttributes[Index].first, Name);
+        EXPECT_EQ(Entity.AttributeValue(Name), Index == 7 ? "seven" : std::to_string(Index));
+    }
+    EXPECT_FALSE(Entity.AttributeExists("attr60"));
+    EXPECT_EQ(Entity.AttributeValue("attr60"), "");
+    const std::string &Value = Entity.AttributeValue("attr59");
+    EXPECT_EQ(&Value, &Entity.DAttributes[59].second);
+    
+    SXMLEntity Copy = Entity;
+    Entity.DAttributes.clear();
+    EXPECT_FALSE(Entity.AttributeExists("attr1"));
+    EXPECT_EQ(Copy.AttributeValue("attr1"), "1");
+}
+
+TEST(XMLEntityTest, MovedFromAttributes) {
+    for(int Count : {2, 20}){
+        SXMLEntity Entity;
+        for(int Index = 0; Index < Count; Index++){
+            Entity.SetAttribute("attr" + std::to_string(Index), std::to_string(Index));
+        }
+        SXMLEntity Moved = std::move(Entity);
+        EXPECT_EQ(Moved.DAttributes.size(), Count);
+        EXPECT_TRUE(Entity.DAttributes.empty());
+        EXPECT_EQ(Entity.DAttributes.begin(), Entity.DAttributes.end());
+        EXPECT_FALSE(Entity.AttributeExists("attr1"));
+        EXPECT_TRUE(Entity.SetAttribute("new", "value"));
+        EXPECT_EQ(Entity.DAttributes.size(), 1);
+        EXPECT_EQ(Entity.AttributeValue("new"), "value");
+        
+        SXMLEntity Assigned;
+        Assigned.SetAttribute("old", "value");
+        Assigned = std::move(Moved);
+        EXPECT_EQ(Assigned.AttributeValue("attr1"), "1");
+        EXPECT_FALSE(Assigned.AttributeExists("old"));
+        EXPECT_TRUE(Moved.DAttributes.empty());
+        Moved.DAttributes.push_back({"a", "b"});
+        EXPECT_EQ(Moved.AttributeValue("a"), "b");
+    }
+}
+
 TEST(XMLReaderTest, EmptyDocument) {
     auto source = std::make_shared<CStringDataSource>("");
     auto Reader = std::make_unique<CXMLReader>(source);
@@ -62,6 +119,304 @@ TEST(XMLReaderTest, ElementWithCharacterData) {
     EXPECT_EQ(Entity.DType, SXMLEntity::EType::EndElement);
 }
 
+TEST(XMLReaderTest, SmallChunks) {
+    auto source = std::make_shared<CStringDataSource>("<document><item key=\"value\">some longer character data</item></document>");
+    CXMLReader Reader(source, 3);
+    SXMLEntity Entity;
+    
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DType, SXMLEntity::EType::StartElement);
+    EXPECT_EQ(Entity.DNameData, "document");
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameData, "item");
+    EXPECT_EQ(Entity.AttributeValue("key"), "value");
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DType, SXMLEntity::EType::CharData);
+    EXPECT_EQ(Entity.DNameData, "some longer character data");
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DType, SXMLEntity::EType::EndElement);
+    EXPECT_EQ(Entity.DNameData, "item");
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameData, "document");
+    EXPECT_FALSE(Reader.ReadEntity(Entity));
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(XMLReaderTest, InternedNames) {
+    auto source = std::make_shared<CStringDataSource>("<osm><node id=\"1\"/><node id=\"2\">x</node></osm>");
+    CXMLReader Reader(source);
+    std::string_view NodeName = Reader.NameTable().Intern("node");
+    std::string_view IdName = Reader.NameTable().Intern("id");
+    SXMLInternedEntity Entity;
+    std::vector< std::string > Ids;
+    
+    while(Reader.ReadEntity(Entity, true)){
+        if(Entity.DType == SXMLEntity::EType::StartElement && Entity.DName.data() == NodeName.data()){
+            ASSERT_NE(Entity.AttributeValue(IdName), nullptr);
+            EXPECT_EQ(Entity.DAttributes[0].first.data(), IdName.data());
+            Ids.push_back(*Entity.AttributeValue(IdName));
+        }
+    }
+    EXPECT_EQ(Ids, std::vector< std::string >({"1", "2"}));
+    EXPECT_EQ(Reader.NameTable().Size(), 3);
+    EXPECT_EQ(Reader.NameTable().Find("osm"), "osm");
+    EXPECT_TRUE(Reader.NameTable().Find("way").empty());
+}
+
+TEST(XMLReaderTest, EntityCapacityReused) {
+    std::string Document = "<rows>";
+    for(int Index = 0; Index < 100; Index++){
+        Document += "<row value=\"a value longer than the small string buffer " + std::to_string(Index) + "\"/>";
+    }
+    Document += "</rows>";
+    CXMLReader Reader(std::make_shared<CStringDataSource>(Document), 128);
+    SXMLEntity Entity;
+    
+    const char *ValueData = nullptr;
+    int Rows = 0;
+    while(Reader.ReadEntity(Entity)){
+        if(Entity.DType == SXMLEntity::EType::StartElement && Entity.DNameData == "row"){
+            EXPECT_EQ(Entity.AttributeValue("value"), "a value longer than the small string buffer " + std::to_string(Rows));
+            // Values from row 10 on have the same length, so the string
+            // must not be reallocated once it has held one of them
+            if(Rows == 10){
+                ValueData = Entity.DAttributes[0].second.data();
+            }
+            else if(Rows > 10){
+                EXPECT_EQ(Entity.DAttributes[0].second.data(), ValueData);
+            }
+            Rows++;
+        }
+    }
+    EXPECT_EQ(Rows, 100);
+}
+
+// Records the handler calls as text for comparison
+class CRecordingHandler : public CXMLHandler{
+    public:
+        std::string DEvents;
+
+        void OnStart(std::string_view name, const std::vector< SXMLAttributeView > &attributes) override{
+            DEvents += "<" + std::string(name);
+            for(auto &Attribute : attributes){
+                DEvents += " " + std::string(Attribute.DName) + "=" + std::string(Attribute.DValue);
+            }
+            DEvents += ">";
+        }
+
+        void OnEnd(std::string_view name) override{
+            DEvents += "</" + std::string(name) + ">";
+        }
+
+        void OnCharData(std::string_view data) override{
+            DEvents += data;
+        }
+};
+
+TEST(XMLReaderTest, ParseWithHandler) {
+    auto source = std::make_shared<CStringDataSource>("<osm><node id=\"1\" type=\"x\">text &amp; more</node><way/></osm>");
+    CXMLReader Reader(source);
+    CRecordingHandler Handler;
+    
+    EXPECT_TRUE(Reader.Parse(Handler));
+    EXPECT_EQ(Handler.DEvents, "<osm><node id=1 type=x>text & more</node><way></way></osm>");
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(XMLReaderTest, ParseAfterReadEntity) {
+    auto source = std::make_shared<CStringDataSource>("<root><a>1</a><b/></root>");
+    CXMLReader Reader(source);
+    CRecordingHandler Handler;
+    SXMLEntity Entity;
+    
+    EXPECT_TRUE(Reader.ReadEntity(Entity));
+    EXPECT_EQ(Entity.DNameData, "root");
+    EXPECT_TRUE(Reader.Parse(Handler));
+    EXPECT_EQ(Handler.DEvents, "<a>1</a><b></b></root>");
+}
+
+TEST(XMLReaderTest, ParseError) {
+    auto source = std::make_shared<CStringDataSource>("<root><a></b></root>");
+    CXMLReader Reader(source);
+    CXMLHandler Handler;
+    
+    EXPECT_FALSE(Reader.Parse(Handler));
+}
+
+TEST(XMLPathFilterTest, ChildPath) {
+    CRecordingHandler Handler;
+    CXMLPathFilter Filter("/osm/node[@type='x']/tag", Handler);
+    CXMLReader Reader(std::make_shared<CStringDataSource>(
+        "<osm><node type=\"x\"><tag k=\"a\">1</tag><other><tag k=\"b\"/></other></node>"
+        "<node type=\"y\"><tag k=\"c\"/></node><tag k=\"d\"/><node type=\"x\"><tag k=\"e\"/></node></osm>"));
+    
+    ASSERT_TRUE(Filter.Valid());
+    EXPECT_TRUE(Reader.Parse(Filter));
+    EXPECT_EQ(Handler.DEvents, "<tag k=a>1</tag><tag k=e></tag>");
+}
+
+TEST(XMLPathFilterTest, WildcardAndSubtree) {
+    CRecordingHandler Handler;
+    CXMLPathFilter Filter("/root/*[@id]", Handler);
+    CXMLReader Reader(std::make_shared<CStringDataSource>("<root><a id=\"1\"><b>x</b></a><c/><d id=\"2\"/></root>"));
+    
+    EXPECT_TRUE(Reader.Parse(Filter));
+    EXPECT_EQ(Handler.DEvents, "<a id=1><b>x</b></a><d id=2></d>");
+}
+
+TEST(XMLPathFilterTest, InvalidPaths) {
+    CXMLHandler Handler;
+    
+    EXPECT_FALSE(CXMLPathFilter("", Handler).Valid());
+    EXPECT_FALSE(CXMLPathFilter("root", Handler).Valid());
+    EXPECT_FALSE(CXMLPathFilter("/root//a", Handler).Valid());
+    EXPECT_FALSE(CXMLPathFilter("/root/a[id]", Handler).Valid());
+    EXPECT_FALSE(CXMLPathFilter("/root/a[@id='1]", Handler).Valid());
+    EXPECT_TRUE(CXMLPathFilter("/root/a[@id=\"1\"][@b]", Handler).Valid());
+}
+
+TEST(XMLPathFilterTest, PathReader) {
+    std::string Document = "<rows>";
+    for(int Index = 0; Index < 50; Index++){
+        Document += "<row id=\"" + std::to_string(Index) + "\"><skip>ignored text</skip><value>" + std::to_string(Index) + "</value></row>";
+    }
+    Document += "</rows>";
+    CXMLPathReader Reader(std::make_shared<CStringDataSource>(Document), "/rows/row/value", 16);
+    SXMLEntity Entity;
+    
+    ASSERT_TRUE(Reader.Valid());
+    for(int Index = 0; Index < 50; Index++){
+        ASSERT_TRUE(Reader.ReadEntity(Entity));
+        EXPECT_EQ(Entity.DType, SXMLEntity::EType::StartElement);
+        EXPECT_EQ(Entity.DNameData, "value");
+        ASSERT_TRUE(Reader.ReadEntity(Entity));
+        EXPECT_EQ(Entity.DType, SXMLEntity::EType::CharData);
+        EXPECT_EQ(Entity.DNameData, std::to_string(Index));
+        ASSERT_TRUE(Reader.ReadEntity(Entity));
+        EXPECT_EQ(Entity.DType, SXMLEntity::EType::EndElement);
+    }
+    EXPECT_FALSE(Reader.ReadEntity(Entity));
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(XMLPathFilterTest, PathReaderSkipCData) {
+    CXMLPathReader Reader(std::make_shared<CStringDataSource>("<a><b x=\"1\">text</b><b x=\"2\"/></a>"), "/a/b[@x='2']");
+    SXMLEntity Entity;
+    
+    ASSERT_TRUE(Reader.ReadEntity(Entity, true));
+    EXPECT_EQ(Entity.DType, SXMLEntity::EType::StartElement);
+    EXPECT_EQ(Entity.AttributeValue("x"), "2");
+    ASSERT_TRUE(Reader.ReadEntity(Entity, true));
+    EXPECT_EQ(Entity.DType, SXMLEntity::EType::EndElement);
+    EXPECT_FALSE(Reader.ReadEntity(Entity, true));
+}
+
+TEST(ParallelXMLReaderTest, RecordsInOrder) {
+    std::string Document = "<?xml version=\"1.0\"?>\n<rows xmlns:x=\"urn:x\">\n";
+    for(int Index = 0; Index < 500; Index++){
+        Document += "  <row id=\"" + std::to_string(Index) + "\" note=\"a > b\"><value>" + std::to_string(Index) + "</value></row>\n";
+        if(Index % 7 == 0){
+            Document += "  <!-- <row id=\"comment\"> --><meta/>\n";
+        }
+    }
+    Document += "</rows>\n";
+    CParallelXMLReader Reader(std::make_shared<CStringDataSource>(Document), "row", 3, 256);
+    std::vector<SXMLEntity> Record;
+    
+    for(int Index = 0; Index < 500; Index++){
+        ASSERT_TRUE(Reader.ReadRecord(Record));
+        ASSERT_EQ(Record.size(), 5);
+        EXPECT_EQ(Record[0].DType, SXMLEntity::EType::StartElement);
+        EXPECT_EQ(Record[0].DNameData, "row");
+        EXPECT_EQ(Record[0].AttributeValue("id"), std::to_string(Index));
+        EXPECT_EQ(Record[0].AttributeValue("note"), "a > b");
+        EXPECT_EQ(Record[1].DNameData, "value");
+        EXPECT_EQ(Record[2].DType, SXMLEntity::EType::CharData);
+        EXPECT_EQ(Record[2].DNameData, std::to_string(Index));
+        EXPECT_EQ(Record[4].DType, SXMLEntity::EType::EndElement);
+        EXPECT_EQ(Record[4].DNameData, "row");
+    }
+    EXPECT_FALSE(Reader.ReadRecord(Record));
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Reader.Error());
+}
+
+TEST(ParallelXMLReaderTest, NestedRecordsAndEntities) {
+    std::string Document = "<!DOCTYPE rows [<!ENTITY e \"expanded\">]><rows>"
+        "<row><row>inner</row><![CDATA[</row>]]></row><other/><row>&e;</row></rows>";
+    CParallelXMLReader Reader(std::make_shared<CStringDataSource>(Document), "row", 2, 1);
+    std::vector<SXMLEntity> Record;
+    
+    ASSERT_TRUE(Reader.ReadRecord(Record));
+    ASSERT_EQ(Record.size(), 6);
+    EXPECT_EQ(Record[1].DNameData, "row");
+    EXPECT_EQ(Record[2].DNameData, "inner");
+    EXPECT_EQ(Record[4].DNameData, "</row>");
+    ASSERT_TRUE(Reader.ReadRecord(Record));
+    ASSERT_EQ(Record.size(), 3);
+    EXPECT_EQ(Record[1].DNameData, "expanded");
+    EXPECT_FALSE(Reader.ReadRecord(Record));
+}
+
+TEST(ParallelXMLReaderTest, AllChildren) {
+    CParallelXMLReader Reader(std::make_shared<CStringDataSource>("<root><a/><b x=\"1\"/></root>"), "", 2, 1);
+    std::vector<SXMLEntity> Record;
+    
+    ASSERT_TRUE(Reader.ReadRecord(Record));
+    EXPECT_EQ(Record[0].DNameData, "a");
+    ASSERT_TRUE(Reader.ReadRecord(Record));
+    EXPECT_EQ(Record[0].DNameData, "b");
+    EXPECT_FALSE(Reader.ReadRecord(Record));
+}
+
+TEST(ParallelXMLReaderTest, ParseError) {
+    CParallelXMLReader Reader(std::make_shared<CStringDataSource>("<rows><row>1</row><row><a></row></rows>"), "row", 1, 1);
+    std::vector<SXMLEntity> Record;
+    
+    ASSERT_TRUE(Reader.ReadRecord(Record));
+    EXPECT_FALSE(Reader.ReadRecord(Record));
+    EXPECT_TRUE(Reader.Error());
+}
+
+TEST(ParallelXMLReaderTest, TruncatedDocument) {
+    std::string Records = "<rows><row>1</row><row>2</row>";
+    for(auto Tail : {"<row>3", "<row>3</ro", "<row>3</row>", "", "</rows><junk/>"}){
+        for(std::size_t ChunkSize : {1, 65536}){
+            CParallelXMLReader Reader(std::make_shared<CStringDataSource>(Records + Tail), "row", 2, ChunkSize);
+            std::vector<SXMLEntity> Record;
+            std::size_t Count = 0;
+            
+            while(Reader.ReadRecord(Record)){
+                Count++;
+            }
+            EXPECT_EQ(Count, std::string(Tail) == "<row>3</row>" ? 3 : 2) << Tail;
+            EXPECT_TRUE(Reader.Error()) << Tail;
+            EXPECT_TRUE(Reader.End());
+        }
+    }
+}
+
+TEST(ParallelXMLReaderTest, CompleteDocumentTail) {
+    CParallelXMLReader Reader(std::make_shared<CStringDataSource>("<rows><row>1</row></rows>\n<!-- done --><?pi x?>\n"), "row", 2, 1);
+    std::vector<SXMLEntity> Record;
+    
+    ASSERT_TRUE(Reader.ReadRecord(Record));
+    EXPECT_FALSE(Reader.ReadRecord(Record));
+    EXPECT_FALSE(Reader.Error());
+}
+
+TEST(ParallelXMLReaderTest, RecordsBeforeErrorInChunk) {
+    CParallelXMLReader Reader(std::make_shared<CStringDataSource>("<rows><row>1</row><row>2</row><row><a></row><row>4</row></rows>"), "row", 1, 65536);
+    std::vector<SXMLEntity> Record;
+    
+    ASSERT_TRUE(Reader.ReadRecord(Record));
+    EXPECT_EQ(Record[1].DNameData, "1");
+    ASSERT_TRUE(Reader.ReadRecord(Record));
+    EXPECT_EQ(Record[1].DNameData, "2");
+    EXPECT_FALSE(Reader.ReadRecord(Record));
+    EXPECT_TRUE(Reader.Error());
+}
+
 TEST(XMLWriterTest, WriteStartElement) {
     auto Sink = std::make_shared<CStringDataSink>();
     auto Writer = std::make_unique<CXMLWriter>(Sink);
@@ -157,4 +512,235 @@ TEST(XMLWriterTest, FlushOperation) {
     auto Writer = std::make_unique<CXMLWriter>(Sink);
     
     EXPECT_TRUE(Writer->Flush());
-}
\ No newline at end of file
+}
+TEST(XMLWriterTest, BufferedOutput) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    {
+        CXMLWriter Writer(Sink, 1024);
+        
+        EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::StartElement, "root", {{"a", "1 & 2"}}}));
+        EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::CharData, "x < y", {}}));
+        EXPECT_EQ(Sink->String(), "");
+        EXPECT_TRUE(Writer.Flush());
+        EXPECT_EQ(Sink->String(), "<root a=\"1 &amp; 2\">x &lt; y");
+        EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::EndElement, "root", {}}));
+        EXPECT_EQ(Sink->String(), "<root a=\"1 &amp; 2\">x &lt; y");
+    }
+    EXPECT_EQ(Sink->String(), "<root a=\"1 &amp; 2\">x &lt; y</root>");
+}
+
+TEST(XMLWriterTest, EscapeLongCharData) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(Sink);
+    const char *Escapes[] = {"&amp;", "&lt;", "&gt;", "&quot;", "&apos;"};
+    std::string Data, Expected;
+    
+    // Special characters at every offset within and across 16 byte blocks
+    for(int Index = 0; Index < 200; Index++){
+        Data += std::string(Index % 19, 'x') + "&<>\"'"[Index % 5];
+        Expected += std::string(Index % 19, 'x') + Escapes[Index % 5];
+    }
+    Data += "trailing text without specials";
+    Expected += "trailing text without specials";
+    EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::CharData, Data, {}}));
+    EXPECT_EQ(Sink->String(), Expected);
+}
+
+TEST(XMLWriterTest, IndentedFormat) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(Sink, 0, CXMLWriter::EFormat::Indented);
+    std::vector<SXMLEntity> Entities = {
+        {SXMLEntity::EType::StartElement, "root", {}},
+        {SXMLEntity::EType::CharData, "\n  ", {}},
+        {SXMLEntity::EType::StartElement, "a", {{"id", "1"}}},
+        {SXMLEntity::EType::CharData, "text", {}},
+        {SXMLEntity::EType::EndElement, "a", {}},
+        {SXMLEntity::EType::StartElement, "b", {}},
+        {SXMLEntity::EType::CompleteElement, "c", {}},
+        {SXMLEntity::EType::StartElement, "d", {}},
+        {SXMLEntity::EType::CharData, "mixed ", {}},
+        {SXMLEntity::EType::CompleteElement, "e", {}},
+        {SXMLEntity::EType::EndElement, "d", {}},
+        {SXMLEntity::EType::EndElement, "b", {}},
+        {SXMLEntity::EType::StartElement, "f", {}},
+        {SXMLEntity::EType::EndElement, "f", {}},
+        {SXMLEntity::EType::EndElement, "root", {}}
+    };
+    
+    for(auto &Entity : Entities){
+        EXPECT_TRUE(Writer.WriteEntity(Entity));
+    }
+    EXPECT_EQ(Sink->String(), "<root>\n  <a id=\"1\">text</a>\n  <b>\n    <c/>\n    <d>mixed <e/></d>\n  </b>\n  <f></f>\n</root>");
+}
+
+TEST(XMLWriterTest, CompactFormat) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(Sink, 0, CXMLWriter::EFormat::Compact);
+    std::vector<SXMLEntity> Entities = {
+        {SXMLEntity::EType::StartElement, "root", {}},
+        {SXMLEntity::EType::CharData, "\n  ", {}},
+        {SXMLEntity::EType::StartElement, "a", {}},
+        {SXMLEntity::EType::CharData, " keep  this ", {}},
+        {SXMLEntity::EType::EndElement, "a", {}},
+        {SXMLEntity::EType::CharData, "\n", {}},
+        {SXMLEntity::EType::EndElement, "root", {}}
+    };
+    
+    for(auto &Entity : Entities){
+        EXPECT_TRUE(Writer.WriteEntity(Entity));
+    }
+    EXPECT_EQ(Sink->String(), "<root><a> keep  this </a></root>");
+}
+
+TEST(XMLWriterTest, CanonicalFormat) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(Sink, 0, CXMLWriter::EFormat::Canonical);
+    std::vector<SXMLEntity> Entities = {
+        {SXMLEntity::EType::StartElement, "root", {{"z", "1"}, {"a", "2"}, {"m", "3"}}},
+        {SXMLEntity::EType::CharData, "\n  some   text ", {}},
+        {SXMLEntity::EType::CharData, "\tsplit\n", {}},
+        {SXMLEntity::EType::CompleteElement, "empty", {{"y", "<"}, {"x", ""}}},
+        {SXMLEntity::EType::CharData, "  ", {}},
+        {SXMLEntity::EType::EndElement, "root", {}}
+    };
+    
+    for(auto &Entity : Entities){
+        EXPECT_TRUE(Writer.WriteEntity(Entity));
+    }
+    EXPECT_EQ(Sink->String(), "<root a=\"2\" m=\"3\" z=\"1\">some text split <empty x=\"\" y=\"&lt;\"></empty></root>");
+}
+
+TEST(XMLWriterTest, IndentedMixedContent) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(Sink, 0, CXMLWriter::EFormat::Indented);
+    std::vector<SXMLEntity> Entities = {
+        {SXMLEntity::EType::StartElement, "root", {}},
+        {SXMLEntity::EType::CharData, "\n  ", {}},
+        {SXMLEntity::EType::StartElement, "p", {}},
+        {SXMLEntity::EType::CharData, "\n", {}},
+        {SXMLEntity::EType::StartElement, "b", {}},
+        {SXMLEntity::EType::CompleteElement, "i", {}},
+        {SXMLEntity::EType::EndElement, "b", {}},
+        {SXMLEntity::EType::CharData, " ", {}},
+        {SXMLEntity::EType::CompleteElement, "br", {}},
+        {SXMLEntity::EType::CharData, " tail", {}},
+        {SXMLEntity::EType::CompleteElement, "br", {}},
+        {SXMLEntity::EType::EndElement, "p", {}},
+        {SXMLEntity::EType::StartElement, "q", {}},
+        {SXMLEntity::EType::CompleteElement, "c", {}},
+        {SXMLEntity::EType::EndElement, "q", {}},
+        {SXMLEntity::EType::EndElement, "root", {}}
+    };
+    
+    for(auto &Entity : Entities){
+        EXPECT_TRUE(Writer.WriteEntity(Entity));
+    }
+    EXPECT_EQ(Sink->String(), "<root>\n  <p>\n    <b>\n      <i/>\n    </b>\n    <br/> tail<br/></p>\n  <q>\n    <c/>\n  </q>\n</root>");
+}
+
+TEST(XMLWriterTest, IndentedStreamsBeforeRootEnds) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(Sink, 4096, CXMLWriter::EFormat::Indented);
+    
+    EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::StartElement, "rows", {}}));
+    for(int Index = 0; Index < 1000; Index++){
+        EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::CharData, "\n  ", {}}));
+        EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::StartElement, "row", {}}));
+        EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::CharData, "hello", {}}));
+        EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::EndElement, "row", {}}));
+    }
+    // Only the output since the last flush is held back
+    std::size_t Written = Sink->String().size();
+    EXPECT_GT(Written, 16000u);
+    EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::EndElement, "rows", {}}));
+    EXPECT_TRUE(Writer.Flush());
+    EXPECT_LT(Sink->String().size() - Written, 4096u + 32u);
+    EXPECT_EQ(Sink->String().substr(0, 38), "<rows>\n  <row>hello</row>\n  <row>hello");
+    EXPECT_EQ(Sink->String().substr(Sink->String().size() - 27), "\n  <row>hello</row>\n</rows>");
+}
+
+TEST(XMLWriterTest, IndentedCollapseEmpty) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(Sink, 0, CXMLWriter::EFormat::Indented, true);
+    std::vector<SXMLEntity> Entities = {
+        {SXMLEntity::EType::StartElement, "root", {}},
+        {SXMLEntity::EType::CharData, "\n  ", {}},
+        {SXMLEntity::EType::StartElement, "a", {}},
+        {SXMLEntity::EType::CharData, " ", {}},
+        {SXMLEntity::EType::EndElement, "a", {}},
+        {SXMLEntity::EType::StartElement, "b", {}},
+        {SXMLEntity::EType::CharData, " ", {}},
+        {SXMLEntity::EType::CharData, "text", {}},
+        {SXMLEntity::EType::EndElement, "b", {}},
+        {SXMLEntity::EType::EndElement, "root", {}}
+    };
+    
+    for(auto &Entity : Entities){
+        EXPECT_TRUE(Writer.WriteEntity(Entity));
+    }
+    EXPECT_EQ(Sink->String(), "<root>\n  <a/>\n  <b> text</b>\n</root>");
+}
+
+TEST(XMLWriterTest, CanonicalMixedContent) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(Sink, 0, CXMLWriter::EFormat::Canonical);
+    std::vector<SXMLEntity> Entities = {
+        {SXMLEntity::EType::StartElement, "p", {}},
+        {SXMLEntity::EType::CharData, " a ", {}},
+        {SXMLEntity::EType::CompleteElement, "b", {}},
+        {SXMLEntity::EType::CharData, " c", {}},
+        {SXMLEntity::EType::StartElement, "i", {}},
+        {SXMLEntity::EType::CharData, " d  ", {}},
+        {SXMLEntity::EType::EndElement, "i", {}},
+        {SXMLEntity::EType::CharData, "\n", {}},
+        {SXMLEntity::EType::StartElement, "i", {}},
+        {SXMLEntity::EType::CharData, "e", {}},
+        {SXMLEntity::EType::EndElement, "i", {}},
+        {SXMLEntity::EType::CharData, "f\t", {}},
+        {SXMLEntity::EType::EndElement, "p", {}}
+    };
+    
+    for(auto &Entity : Entities){
+        EXPECT_TRUE(Writer.WriteEntity(Entity));
+    }
+    EXPECT_EQ(Sink->String(), "<p>a <b></b> c<i>d</i> <i>e</i>f</p>");
+}
+
+TEST(XMLWriterTest, CollapseEmptyElements) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(Sink, 0, CXMLWriter::EFormat::Raw, true);
+    std::vector<SXMLEntity> Entities = {
+        {SXMLEntity::EType::StartElement, "root", {}},
+        {SXMLEntity::EType::StartElement, "a", {{"id", "1"}}},
+        {SXMLEntity::EType::EndElement, "a", {}},
+        {SXMLEntity::EType::StartElement, "b", {}},
+        {SXMLEntity::EType::CharData, "", {}},
+        {SXMLEntity::EType::EndElement, "b", {}},
+        {SXMLEntity::EType::StartElement, "c", {}},
+        {SXMLEntity::EType::CharData, "text", {}},
+        {SXMLEntity::EType::EndElement, "c", {}}
+    };
+    
+    for(auto &Entity : Entities){
+        EXPECT_TRUE(Writer.WriteEntity(Entity));
+    }
+    EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::StartElement, "d", {}}));
+    EXPECT_EQ(Sink->String(), "<root><a id=\"1\"/><b/><c>text</c><d");
+    EXPECT_TRUE(Writer.Flush());
+    EXPECT_EQ(Sink->String(), "<root><a id=\"1\"/><b/><c>text</c><d>");
+    EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::EndElement, "d", {}}));
+    EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::EndElement, "root", {}}));
+    EXPECT_EQ(Sink->String(), "<root><a id=\"1\"/><b/><c>text</c><d></d></root>");
+}
+
+TEST(XMLWriterTest, MismatchedEndElement) {
+    auto Sink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(Sink);
+    
+    EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::StartElement, "root", {}}));
+    EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::StartElement, "a", {}}));
+    EXPECT_FALSE(Writer.WriteEntity({SXMLEntity::EType::EndElement, "root", {}}));
+    EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::EndElement, "a", {}}));
+    EXPECT_TRUE(Writer.WriteEntity({SXMLEntity::EType::EndElement, "root", {}}));
+    EXPECT_EQ(Sink->String(), "<root><a></a></root>");
+}